@@ -0,0 +1,78 @@
+#include "set.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+	@file build_bench.cpp
+	@brief Scaling of the parallel construction of a hashed set
+
+	A hashed set of strings is built from a sequence with one duplicate
+	every four values, by the serial constructor with insert_or_ignore and
+	by the parallel one with a growing number of threads.
+**/
+
+/**
+	Functor to check whether two strings are equal or not
+*/
+struct equal_string
+{
+	bool operator()(const std::string &a, const std::string &b) const
+	{
+		return a == b;
+	}
+};
+
+/**
+	Functor to compute the hash of a string
+*/
+struct hash_string
+{
+	std::size_t operator()(const std::string &a) const
+	{
+		return std::hash<std::string>()(a);
+	}
+};
+
+typedef set<std::string, equal_string, hash_string> string_set;
+
+/**
+	Time a way of building the set
+
+	@return seconds
+*/
+template <typename Build>
+double run(Build build)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	string_set s = build();
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	if (s.size() == 0)
+		std::cout << "empty" << std::endl;
+	return elapsed.count();
+}
+
+int main(int argc, char *argv[])
+{
+	const int values = argc > 1 ? std::stoi(argv[1]) : 2000000;
+	std::vector<std::string> input;
+	input.reserve(values);
+	for (int i = 0; i < values; ++i)
+		input.push_back("row-" + std::to_string((static_cast<long long>(i) * 7919) % (values - values / 4)));
+
+	unsigned int cores = std::thread::hardware_concurrency();
+	if (cores == 0)
+		cores = 1;
+	std::cout << "values: " << values << ", cores: " << cores << std::endl;
+
+	double serial = run([&input]() { return string_set(input.begin(), input.end(), insert_or_ignore); });
+	std::cout << "serial\t" << serial << " s" << std::endl;
+	for (unsigned int threads = 1; threads <= 2 * cores; threads *= 2)
+	{
+		double time = run([&input, threads]() { return string_set(input.begin(), input.end(), insert_or_ignore, parallel(threads)); });
+		std::cout << threads << " threads\t" << time << " s\t" << serial / time << "x" << std::endl;
+	}
+	return 0;
+}
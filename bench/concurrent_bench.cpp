@@ -0,0 +1,135 @@
+#include "set.h"
+#include "concurrent_set.h"
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+	@file concurrent_bench.cpp
+	@brief Throughput of concurrent_set against a set behind one mutex
+
+	Each thread runs the same mix of operations on keys of its own stream:
+	80% contains, 10% add and 10% remove. The total number of operations
+	per second is printed for a growing number of threads.
+**/
+
+/**
+	Functor to check whether two integers are equal or not
+*/
+struct equal_int
+{
+	bool operator()(int a, int b) const
+	{
+		return a == b;
+	}
+};
+
+/**
+	Functor to compute the hash of an integer
+*/
+struct hash_int
+{
+	std::size_t operator()(int a) const
+	{
+		return static_cast<std::size_t>(a);
+	}
+};
+
+typedef set<int, equal_int, hash_int> int_set;
+
+/**
+	A set shared by all the threads behind a single mutex, the way
+	sets were shared before concurrent_set
+*/
+struct locked_set
+{
+	std::mutex lock;
+	int_set elements;
+
+	bool try_add(int value)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		return elements.try_add(value);
+	}
+
+	bool try_remove(int value)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		return elements.try_remove(value);
+	}
+
+	bool contains(int value)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		return elements.contains(value);
+	}
+};
+
+/**
+	Run the mix of operations on s with a number of threads
+
+	@return millions of operations per second
+*/
+template <typename Set>
+double run(Set &s, unsigned int threads, int operations, int keys)
+{
+	for (int i = 0; i < keys; i += 2)
+		s.try_add(i);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	for (unsigned int t = 0; t < threads; ++t)
+	{
+		workers.push_back(std::thread([&s, t, operations, keys]()
+		{
+			unsigned int state = 2463534242u + t;
+			int hits = 0;
+			for (int i = 0; i < operations; ++i)
+			{
+				// xorshift, so that the threads do not share a generator
+				state ^= state << 13;
+				state ^= state >> 17;
+				state ^= state << 5;
+				int key = static_cast<int>(state % static_cast<unsigned int>(keys));
+				unsigned int kind = (state >> 24) % 10;
+				if (kind == 0)
+					hits += s.try_add(key);
+				else if (kind == 1)
+					hits += s.try_remove(key);
+				else
+					hits += s.contains(key);
+			}
+			if (hits < 0)
+				std::cout << hits;
+		}));
+	}
+	for (std::size_t t = 0; t < workers.size(); ++t)
+		workers[t].join();
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return threads * static_cast<double>(operations) / elapsed.count() / 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+	const int operations = argc > 1 ? std::stoi(argv[1]) : 1000000;
+	const int keys = 1 << 16;
+
+	unsigned int cores = std::thread::hardware_concurrency();
+	if (cores == 0)
+		cores = 1;
+	std::cout << "operations per thread: " << operations << ", cores: " << cores << std::endl;
+	std::cout << "threads\tmutex Mops/s\tsharded Mops/s" << std::endl;
+
+	for (unsigned int threads = 1; threads <= 2 * cores; threads *= 2)
+	{
+		locked_set locked;
+		concurrent_set<int, equal_int, hash_int> sharded;
+		double lockedRate = run(locked, threads, operations, keys);
+		double shardedRate = run(sharded, threads, operations, keys);
+		std::cout << threads << '\t' << lockedRate << '\t' << shardedRate << std::endl;
+	}
+	return 0;
+}
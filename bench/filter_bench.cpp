@@ -0,0 +1,86 @@
+#include "set.h"
+#include "parallel_filter.h"
+#include <chrono>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <thread>
+
+/**
+	@file filter_bench.cpp
+	@brief Scaling of the parallel filter_out with the number of threads
+
+	A hashed set of strings is filtered with a regular expression, a
+	predicate heavy enough for the threads to pay off. The time of each
+	run is printed together with the speedup over a single thread.
+**/
+
+/**
+	Functor to check whether two strings are equal or not
+*/
+struct equal_string
+{
+	bool operator()(const std::string &a, const std::string &b) const
+	{
+		return a == b;
+	}
+};
+
+/**
+	Functor to compute the hash of a string
+*/
+struct hash_string
+{
+	std::size_t operator()(const std::string &a) const
+	{
+		return std::hash<std::string>()(a);
+	}
+};
+
+/**
+	Predicate satisfied by the strings that look like an e-mail address
+	of an italian domain
+*/
+struct is_italian_mail
+{
+	std::regex pattern;
+
+	is_italian_mail() : pattern("^[a-z0-9._]+@([a-z0-9-]+\\.)+it$")
+	{}
+
+	bool operator()(const std::string &a) const
+	{
+		return std::regex_match(a, pattern);
+	}
+};
+
+typedef set<std::string, equal_string, hash_string> string_set;
+
+int main(int argc, char *argv[])
+{
+	const int count = argc > 1 ? std::stoi(argv[1]) : 200000;
+	const char* domains[] = {"unimib.it", "mail.example.com", "dipartimento.unimi.it", "example.org"};
+
+	string_set mails;
+	mails.reserve(count);
+	for (int i = 0; i < count; ++i)
+		mails.add("user." + std::to_string(i) + "@" + domains[i % 4]);
+
+	unsigned int cores = std::thread::hardware_concurrency();
+	if (cores == 0)
+		cores = 1;
+	std::cout << "elements: " << count << ", cores: " << cores << std::endl;
+	std::cout << "threads\tms\tspeedup\tkept" << std::endl;
+
+	double single = 0;
+	for (unsigned int threads = 1; threads <= 2 * cores; threads *= 2)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		string_set kept = filter_out(mails, is_italian_mail(), parallel(threads));
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		if (threads == 1)
+			single = elapsed.count();
+		std::cout << threads << '\t' << elapsed.count() << '\t' << single / elapsed.count() << '\t' << kept.size() << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,385 @@
+#include "set.h"
+#include "flat_set.h"
+#include "student.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/**
+	@file set_bench.cpp
+	@brief Benchmark suite of the sets against the standard containers
+
+	Each operation is timed for each container, type of element and size,
+	and the results are written on the standard output as CSV (the
+	default) or as JSON (--json), one record per measure with the time per
+	element in nanoseconds. The operations are:
+
+	- add: insert the elements, one at a time, into an empty container;
+	- remove: remove all the elements, one at a time;
+	- subscript: read all the elements by position (sets only);
+	- iterate: read all the elements by iterator;
+	- filter_out: build a container with the elements of odd key;
+	- plus: join two halves of the elements, checking for duplicates;
+	- copy: copy the container;
+	- destroy: destroy a copy of the container.
+
+	Sizes go from 100 to --max (1000000 by default) by powers of 10.
+	The sets without hash index take O(n) per lookup, so they are only
+	measured up to 10000 elements. Small sizes are repeated so that each
+	measure takes some milliseconds.
+**/
+
+/**
+	Functor to check whether two values are equal or not
+*/
+struct equal_value
+{
+	template <typename T>
+	bool operator()(const T &a, const T &b) const
+	{
+		return a == b;
+	}
+};
+
+/**
+	Functor to compute the hash of a value
+*/
+struct hash_value
+{
+	std::size_t operator()(int a) const
+	{
+		return static_cast<std::size_t>(a);
+	}
+
+	std::size_t operator()(const std::string &a) const
+	{
+		return std::hash<std::string>()(a);
+	}
+
+	std::size_t operator()(const student &a) const
+	{
+		return std::hash<std::string>()(a.name) * 31 + a.age;
+	}
+};
+
+/**
+	Functor to order two values, for std::set
+*/
+struct less_value
+{
+	template <typename T>
+	bool operator()(const T &a, const T &b) const
+	{
+		return a < b;
+	}
+
+	bool operator()(const student &a, const student &b) const
+	{
+		return a.age < b.age || (a.age == b.age && a.name < b.name);
+	}
+};
+
+/**
+	Predicate telling whether the key of a value is odd
+*/
+struct odd_key
+{
+	bool operator()(int a) const
+	{
+		return (a & 1) != 0;
+	}
+
+	bool operator()(const std::string &a) const
+	{
+		return (a[a.size() - 1] & 1) != 0;
+	}
+
+	bool operator()(const student &a) const
+	{
+		return (a.age & 1) != 0;
+	}
+};
+
+/**
+	The i-th value of a benchmark, all different and spread out
+*/
+template <typename T>
+T make_value(unsigned int i);
+
+template <>
+int make_value<int>(unsigned int i)
+{
+	return static_cast<int>(i * 2654435761u);
+}
+
+template <>
+std::string make_value<std::string>(unsigned int i)
+{
+	return "key-" + std::to_string(i * 2654435761u);
+}
+
+template <>
+student make_value<student>(unsigned int i)
+{
+	return student(i % 97, "student-" + std::to_string(i * 2654435761u));
+}
+
+/**
+	Name of the type of the elements
+*/
+template <typename T> const char* type_name();
+template <> const char* type_name<int>() { return "int"; }
+template <> const char* type_name<std::string>() { return "string"; }
+template <> const char* type_name<student>() { return "student"; }
+
+/**
+	Trait telling whether a container is a standard one
+*/
+template <typename C> struct is_standard : std::false_type {};
+template <typename T, typename H, typename E, typename A> struct is_standard<std::unordered_set<T, H, E, A> > : std::true_type {};
+template <typename T, typename L, typename A> struct is_standard<std::set<T, L, A> > : std::true_type {};
+
+/**
+	Add a value to a container
+*/
+template <typename C, typename T>
+void add_to(C &c, const T &value)
+{
+	if constexpr (is_standard<C>::value)
+		c.insert(value);
+	else
+		c.add(value);
+}
+
+/**
+	Remove a value from a container
+*/
+template <typename C, typename T>
+void remove_from(C &c, const T &value)
+{
+	if constexpr (is_standard<C>::value)
+		c.erase(value);
+	else
+		c.remove(value);
+}
+
+/**
+	Filter out the odd keys of a container
+*/
+template <typename C>
+C filter_odd(const C &c)
+{
+	if constexpr (is_standard<C>::value)
+	{
+		C result;
+		for (typename C::const_iterator ib = c.begin(), ie = c.end(); ib != ie; ++ib)
+			if (!odd_key()(*ib))
+				result.insert(*ib);
+		return result;
+	}
+	else
+		return filter_out(c, odd_key());
+}
+
+/**
+	Join two containers, failing on duplicates
+*/
+template <typename C>
+C join(const C &a, const C &b)
+{
+	if constexpr (is_standard<C>::value)
+	{
+		C result(a);
+		for (typename C::const_iterator ib = b.begin(), ie = b.end(); ib != ie; ++ib)
+			if (!result.insert(*ib).second)
+				throw duplicated_element_exception();
+		return result;
+	}
+	else
+		return a + b;
+}
+
+/**
+	A measure of the suite
+*/
+struct measure
+{
+	const char* container;
+	const char* type;
+	std::size_t size;
+	const char* operation;
+	double nanoseconds; ///< time per element
+};
+
+/// sum of the values read, so that the reads are not optimized away
+static std::size_t sink = 0;
+
+/**
+	Time an operation, repeating it to last some milliseconds
+
+	@param setup called before each repetition, not timed
+	@param work the operation
+	@return the seconds of one repetition
+*/
+template <typename Setup, typename Work>
+double time_it(std::size_t repetitions, Setup setup, Work work)
+{
+	double total = 0;
+	for (std::size_t r = 0; r < repetitions; ++r)
+	{
+		setup();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		work();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		total += elapsed.count();
+	}
+	return total / repetitions;
+}
+
+/**
+	Run all the operations on a container of n elements
+*/
+template <typename C, typename T>
+void run(const char* container, std::size_t n, std::vector<measure> &results)
+{
+	std::vector<T> values;
+	values.reserve(n);
+	for (std::size_t i = 0; i < n; ++i)
+		values.push_back(make_value<T>(static_cast<unsigned int>(i)));
+	std::size_t repetitions = n >= 100000 ? 1 : 100000 / n;
+	auto record = [&](const char* operation, double seconds)
+	{
+		measure m = { container, type_name<T>(), n, operation, seconds * 1e9 / n };
+		results.push_back(m);
+	};
+	auto nothing = []() {};
+
+	std::unique_ptr<C> filled;
+	record("add", time_it(repetitions, [&]() { filled.reset(new C()); }, [&]()
+	{
+		for (std::size_t i = 0; i < n; ++i)
+			add_to(*filled, values[i]);
+	}));
+
+	std::unique_ptr<C> emptied;
+	record("remove", time_it(repetitions, [&]() { emptied.reset(new C(*filled)); }, [&]()
+	{
+		for (std::size_t i = 0; i < n; ++i)
+			remove_from(*emptied, values[i]);
+	}));
+	emptied.reset();
+
+	if constexpr (!is_standard<C>::value)
+	{
+		record("subscript", time_it(repetitions, nothing, [&]()
+		{
+			for (unsigned int i = 0; i < n; ++i)
+				sink += reinterpret_cast<std::size_t>(&(*filled)[i]);
+		}));
+	}
+
+	record("iterate", time_it(repetitions, nothing, [&]()
+	{
+		for (typename C::const_iterator ib = filled->begin(), ie = filled->end(); ib != ie; ++ib)
+			sink += reinterpret_cast<std::size_t>(&*ib);
+	}));
+
+	record("filter_out", time_it(repetitions, nothing, [&]()
+	{
+		sink += filter_odd(*filled).size();
+	}));
+
+	C first, second;
+	for (std::size_t i = 0; i < n; ++i)
+		add_to(i % 2 == 0 ? first : second, values[i]);
+	record("plus", time_it(repetitions, nothing, [&]()
+	{
+		sink += join(first, second).size();
+	}));
+
+	std::unique_ptr<C> copy;
+	record("copy", time_it(repetitions, [&]() { copy.reset(); }, [&]()
+	{
+		copy.reset(new C(*filled));
+	}));
+
+	record("destroy", time_it(repetitions, [&]() { copy.reset(new C(*filled)); }, [&]()
+	{
+		copy.reset();
+	}));
+}
+
+/**
+	Run the suite for a type of element
+*/
+template <typename T>
+void run_type(std::size_t maxSize, std::vector<measure> &results)
+{
+	for (std::size_t n = 100; n <= maxSize; n *= 10)
+	{
+		run<set<T, equal_value, hash_value>, T>("set_hashed", n, results);
+		if (n <= 10000)
+			run<set<T, equal_value>, T>("set", n, results);
+		run<flat_set<T, equal_value, hash_value>, T>("flat_set_hashed", n, results);
+		run<std::unordered_set<T, hash_value, equal_value>, T>("std_unordered_set", n, results);
+		run<std::set<T, less_value>, T>("std_set", n, results);
+		std::cerr << type_name<T>() << ' ' << n << " done" << std::endl;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	bool json = false;
+	std::size_t maxSize = 1000000;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--json") == 0)
+			json = true;
+		else if (std::strcmp(argv[i], "--csv") == 0)
+			json = false;
+		else if (std::strcmp(argv[i], "--max") == 0 && i + 1 < argc)
+			maxSize = std::stoul(argv[++i]);
+		else
+		{
+			std::cerr << "usage: " << argv[0] << " [--csv | --json] [--max N]" << std::endl;
+			return 1;
+		}
+	}
+
+	std::vector<measure> results;
+	run_type<int>(maxSize, results);
+	run_type<std::string>(maxSize, results);
+	run_type<student>(maxSize, results);
+
+	if (json)
+	{
+		std::cout << "[\n";
+		for (std::size_t i = 0; i < results.size(); ++i)
+		{
+			const measure &m = results[i];
+			std::cout << "  {\"container\":\"" << m.container << "\",\"type\":\"" << m.type
+			          << "\",\"size\":" << m.size << ",\"operation\":\"" << m.operation
+			          << "\",\"ns_per_element\":" << m.nanoseconds << '}' << (i + 1 < results.size() ? ",\n" : "\n");
+		}
+		std::cout << "]\n";
+	}
+	else
+	{
+		std::cout << "container,type,size,operation,ns_per_element\n";
+		for (std::size_t i = 0; i < results.size(); ++i)
+		{
+			const measure &m = results[i];
+			std::cout << m.container << ',' << m.type << ',' << m.size << ',' << m.operation << ',' << m.nanoseconds << '\n';
+		}
+	}
+	if (sink == 1)
+		std::cerr << sink << std::endl;
+	return 0;
+}
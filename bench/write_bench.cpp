@@ -0,0 +1,83 @@
+#include "set.h"
+#include "bulk_writer.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+/**
+	@file write_bench.cpp
+	@brief Time to write a large set on a file, operator<< against write_all
+
+	The operator<< of the sets used to end each element with std::endl,
+	flushing the stream every time: that version is timed too, as the
+	baseline the bulk writer replaces.
+**/
+
+/**
+	Functor to check whether two integers are equal or not
+*/
+struct equal_int
+{
+	bool operator()(int a, int b) const
+	{
+		return a == b;
+	}
+};
+
+/**
+	Functor to compute the hash of an integer
+*/
+struct hash_int
+{
+	std::size_t operator()(int a) const
+	{
+		return static_cast<std::size_t>(a);
+	}
+};
+
+typedef set<int, equal_int, hash_int> int_set;
+
+/**
+	Time a way of writing the set on a new file
+
+	@return seconds
+*/
+template <typename Write>
+double run(const char* path, Write write)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	{
+		std::ofstream file(path);
+		write(file);
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+int main(int argc, char *argv[])
+{
+	const int elements = argc > 1 ? std::stoi(argv[1]) : 1000000;
+	const char* path = "write_bench.txt";
+
+	int_set s;
+	s.reserve(elements);
+	for (int i = 0; i < elements; ++i)
+		s.add(i * 7919);
+
+	double flushed = run(path, [&s](std::ostream &os)
+	{
+		for (int_set::const_iterator ib = s.begin(), ie = s.end(); ib != ie; ++ib)
+			os << *ib << std::endl;
+	});
+	double streamed = run(path, [&s](std::ostream &os) { os << s; });
+	double bulk = run(path, [&s](std::ostream &os) { write_all(os, s); });
+	std::remove(path);
+
+	std::cout << "elements: " << elements << std::endl;
+	std::cout << "std::endl\t" << flushed << " s" << std::endl;
+	std::cout << "operator<<\t" << streamed << " s\t" << flushed / streamed << "x" << std::endl;
+	std::cout << "write_all\t" << bulk << " s\t" << flushed / bulk << "x" << std::endl;
+	return 0;
+}
@@ -0,0 +1,600 @@
+#ifndef BLOOM_SET_H
+#define BLOOM_SET_H
+
+#include <bitset>   // std::bitset
+#include <cmath>    // std::pow
+#include <cstddef>  // std::size_t
+#include <cstdint>  // std::uint64_t
+#include <iterator> // std::iterator_traits
+#include <ostream>  // std::ostream
+#include <utility>  // std::move, std::forward
+#include <vector>   // std::vector
+#include "parallel_filter.h"
+#include "non_existent_element_exception.h"
+#include "duplicated_element_exception.h"
+
+/**
+	@file bloom_set.h
+	@brief Declaration of bloom_set class
+**/
+
+/**
+	@brief A set with a Bloom filter in front of it, for fast misses
+
+	It wraps any of the sets (set, flat_set, ordered_set, small_set) and
+	keeps a Bloom filter of its elements, updated by add: contains, find,
+	count, remove and the duplicate checks of operator+ answer for most
+	absent values in O(1) time from the filter, without touching the
+	elements. It pays off when most lookups miss and the wrapped set has
+	no hash index, or its elements are expensive to compare.
+
+	The filter is blocked: the bits of a value all fall in one block of
+	512 bits, a cache line, chosen by its hash. The filter is sized for
+	twice the elements it is built with, and removed values keep their
+	bits, so it is built again from the elements once as many values have
+	been put in it; this takes amortized O(1) time for each add.
+
+	@tparam Set the type of the wrapped set
+	@tparam Hash functor used to compute the hash of an element, consistent with the equality of Set
+*/
+template <typename Set, typename Hash>
+class bloom_set
+{
+public:
+
+	/// The iterator of the wrapped set
+	typedef typename Set::const_iterator const_iterator;
+
+	/// The type of the elements
+	typedef typename std::iterator_traits<const_iterator>::value_type value_type;
+
+private:
+
+	/// bits of a block, a cache line
+	static const std::size_t blockBits = 512;
+
+	/// 64 bit words of a block
+	static const std::size_t blockWords = blockBits / 64;
+
+	/// bits of the hash that pick a bit in a block, log2(blockBits)
+	static const unsigned int bitIndexBits = 9;
+
+	/// bits picked from one mix of the hash
+	static const unsigned int probesPerMix = 64 / bitIndexBits;
+
+	static_assert(blockBits == std::size_t(1) << bitIndexBits, "a block must have 2^bitIndexBits bits");
+
+	Set _set;                            ///< The wrapped set
+	std::vector<std::uint64_t> _filter;  ///< The blocks of the filter
+	unsigned int _blockBits;             ///< log2 of the number of blocks
+	unsigned int _bitsPerElement;        ///< Bits of filter for each value it is sized for
+	unsigned int _probes;                ///< Bits set for each value
+	std::size_t _capacity;               ///< Number of values the filter is sized for, twice the elements
+	std::size_t _inserted;               ///< Number of values put in the filter, removed ones included
+	Hash _hash;                          ///< Functor used to compute the hash of an element
+
+
+	/**
+		Helper function used to mix the bits of a hash, so that weak hashes
+		like the identity on integers still spread over the whole filter.
+
+		@param h the hash of a value
+		@return the mixed hash
+	*/
+	static std::uint64_t mix(std::uint64_t h)
+	{
+		std::uint64_t x = h + 0x9e3779b97f4a7c15ull;
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+		return x ^ (x >> 31);
+	}
+
+
+	/**
+		Helper function used to get the block of a value.
+
+		@param m the mixed hash of the value
+		@return a pointer to the first word of the block
+	*/
+	std::uint64_t* blockOf(std::uint64_t m)
+	{
+		return _filter.data() + (_blockBits == 0 ? 0 : static_cast<std::size_t>(m >> (64 - _blockBits))) * blockWords;
+	}
+
+
+	/** Helper function used to get the block of a value */
+	const std::uint64_t* blockOf(std::uint64_t m) const
+	{
+		return _filter.data() + (_blockBits == 0 ? 0 : static_cast<std::size_t>(m >> (64 - _blockBits))) * blockWords;
+	}
+
+
+	/**
+		Helper function used to pick the bits of a value in its block.
+		The top bits of the mixed hash choose the block, so the bits in the
+		block are taken from a second mix of it: each probe has its own 9
+		bits, and the hash is mixed again every 7 probes. The bits in the
+		block are then independent of each other and of the block, unlike
+		double hashing, whose few distinct patterns in 512 bits made the
+		false positives several times more frequent than expected.
+
+		@param p the hash left from the previous probes
+		@param i the number of the probe
+		@return the bit of the probe, and p is moved to the next probe
+	*/
+	static std::size_t probe(std::uint64_t &p, unsigned int i)
+	{
+		if (i % probesPerMix == 0)
+			p = mix(p);
+		std::size_t bit = static_cast<std::size_t>(p % blockBits);
+		p >>= bitIndexBits;
+		return bit;
+	}
+
+
+	/**
+		Helper function used to put a value in the filter. Its bits are
+		picked in its block by probe.
+
+		@param h the hash of the value
+	*/
+	void mark(std::size_t h)
+	{
+		std::uint64_t m = mix(h);
+		std::uint64_t* block = blockOf(m);
+		std::uint64_t p = m;
+		for (unsigned int i = 0; i < _probes; ++i)
+		{
+			std::size_t bit = probe(p, i);
+			block[bit / 64] |= std::uint64_t(1) << (bit % 64);
+		}
+		++_inserted;
+	}
+
+
+	/**
+		Helper function used to put a new value in the filter, building the
+		filter again if it is full.
+
+		@param h the hash of the value just added to the set
+	*/
+	void added(std::size_t h)
+	{
+		if (_inserted >= _capacity)
+			rebuild();
+		else
+			mark(h);
+	}
+
+
+	/**
+		Helper function used to size the filter for twice the elements of
+		the set and to put them in it.
+	*/
+	void rebuild()
+	{
+		_capacity = _set.size() < 32 ? 64 : 2 * static_cast<std::size_t>(_set.size());
+		std::size_t blocks = 1;
+		_blockBits = 0;
+		while (blocks * blockBits < _capacity * _bitsPerElement)
+		{
+			blocks *= 2;
+			++_blockBits;
+		}
+		_filter.assign(blocks * blockWords, 0);
+		_inserted = 0;
+		for (const_iterator ib = _set.begin(), ie = _set.end(); ib != ie; ++ib)
+			mark(_hash(*ib));
+	}
+
+
+	/**
+		Helper function used to choose the number of bits set for each value,
+		about bitsPerElement * ln(2), the best for an unblocked filter.
+	*/
+	void chooseProbes()
+	{
+		if (_bitsPerElement == 0)
+			_bitsPerElement = 1;
+		_probes = (_bitsPerElement * 693 + 500) / 1000;
+		if (_probes == 0)
+			_probes = 1;
+		if (_probes > 16)
+			_probes = 16;
+	}
+
+public:
+
+	/**
+		@brief Default constructor
+
+		It creates an empty set.
+
+		@param bitsPerElement bits of filter for each element, 10 for about 1% of false positives
+		@throw std::bad_alloc
+	*/
+	explicit bloom_set(unsigned int bitsPerElement = 10)
+		: _blockBits(0), _bitsPerElement(bitsPerElement), _probes(0), _capacity(0), _inserted(0)
+	{
+		chooseProbes();
+		rebuild();
+	}
+
+
+	/**
+		@brief Constructor from a set
+
+		@param s the set to be wrapped, copied
+		@param bitsPerElement bits of filter for each element
+		@throw std::exception
+	*/
+	explicit bloom_set(const Set &s, unsigned int bitsPerElement = 10)
+		: _set(s), _blockBits(0), _bitsPerElement(bitsPerElement), _probes(0), _capacity(0), _inserted(0)
+	{
+		chooseProbes();
+		rebuild();
+	}
+
+
+	/**
+		@brief Constructor from a temporary set
+
+		@param s the set to be wrapped, moved
+		@param bitsPerElement bits of filter for each element
+		@throw std::exception
+	*/
+	explicit bloom_set(Set &&s, unsigned int bitsPerElement = 10)
+		: _set(std::move(s)), _blockBits(0), _bitsPerElement(bitsPerElement), _probes(0), _capacity(0), _inserted(0)
+	{
+		chooseProbes();
+		rebuild();
+	}
+
+
+	/**
+		@brief Get the wrapped set
+
+		@return a reference to the wrapped set
+	*/
+	const Set& get() const
+	{
+		return _set;
+	}
+
+
+	/**
+		@brief Check the filter for a value
+
+		@param value the value to look for
+		@return false if value is certainly not in the set, true if it may be
+	*/
+	bool might_contain(const value_type& value) const
+	{
+		std::uint64_t m = mix(_hash(value));
+		const std::uint64_t* block = blockOf(m);
+		std::uint64_t p = m;
+		for (unsigned int i = 0; i < _probes; ++i)
+		{
+			std::size_t bit = probe(p, i);
+			if ((block[bit / 64] & (std::uint64_t(1) << (bit % 64))) == 0)
+				return false;
+		}
+		return true;
+	}
+
+
+	/**
+		@brief Add an element to the set
+
+		@param val value of the new element
+		@throw duplicated_element_exception
+	*/
+	void add(const value_type& val)
+	{
+		_set.add(val);
+		added(_hash(val));
+	}
+
+
+	/**
+		@brief Add an element to the set, moving its value
+
+		@param val value of the new element
+		@throw duplicated_element_exception
+	*/
+	void add(value_type&& val)
+	{
+		std::size_t h = _hash(val);
+		_set.add(std::move(val));
+		added(h);
+	}
+
+
+	/**
+		@brief Add an element to the set, if it is not there yet
+
+		@param val value of the new element
+		@return true if the element has been added, false if it was already in the set
+	*/
+	bool try_add(const value_type& val)
+	{
+		if (!_set.try_add(val))
+			return false;
+		added(_hash(val));
+		return true;
+	}
+
+
+	/**
+		@brief Add an element to the set moving its value, if it is not there yet
+
+		@param val value of the new element
+		@return true if the element has been added, false if it was already in the set
+	*/
+	bool try_add(value_type&& val)
+	{
+		std::size_t h = _hash(val);
+		if (!_set.try_add(std::move(val)))
+			return false;
+		added(h);
+		return true;
+	}
+
+
+	/**
+		@brief Build an element in place and add it to the set
+
+		@tparam Args the types of the arguments
+		@param args the arguments passed to a constructor of the elements
+		@throw duplicated_element_exception
+	*/
+	template <typename... Args>
+	void emplace(Args&&... args)
+	{
+		add(value_type(std::forward<Args>(args)...));
+	}
+
+
+	/**
+		@brief Delete an element from the set
+
+		If the filter rules the element out, the exception is thrown
+		without looking at the elements.
+
+		@param toDelete value of the element that has to be deleted
+		@throw non_existent_element_exception
+	*/
+	void remove(const value_type& toDelete)
+	{
+		if (!might_contain(toDelete))
+			throw non_existent_element_exception();
+		_set.remove(toDelete);
+	}
+
+
+	/**
+		@brief Delete an element from the set, if it is there
+
+		@param toDelete value of the element that has to be deleted
+		@return true if the element has been removed, false if it was not in the set
+	*/
+	bool try_remove(const value_type& toDelete)
+	{
+		return might_contain(toDelete) && _set.try_remove(toDelete);
+	}
+
+
+	/**
+		@brief Get the element at a position
+
+		@param i the position of the element
+		@return the element at position i
+	*/
+	const value_type& operator[](unsigned int i) const
+	{
+		return _set[i];
+	}
+
+
+	/**
+		@brief Get the number of elements in the set
+
+		@return the size of the set
+	*/
+	unsigned int size() const
+	{
+		return _set.size();
+	}
+
+
+	/**
+		@brief Check whether a value is in the set
+
+		@param value the value to look for
+		@return true if and only if an element equal to value is in the set
+	*/
+	bool contains(const value_type& value) const
+	{
+		return might_contain(value) && _set.contains(value);
+	}
+
+
+	/**
+		@brief Find a value in the set
+
+		@param value the value to look for
+		@return const_iterator to the element, or end() if there is none
+	*/
+	const_iterator find(const value_type& value) const
+	{
+		return might_contain(value) ? _set.find(value) : _set.end();
+	}
+
+
+	/**
+		@brief Count the elements equal to a value
+
+		@param value the value to look for
+		@return the number of elements equal to value, either 0 or 1
+	*/
+	unsigned int count(const value_type& value) const
+	{
+		return contains(value) ? 1 : 0;
+	}
+
+
+	/**
+		@brief Estimate the rate of false positives of the filter
+
+		It is the chance that might_contain is true for a value not in the
+		set, computed from the share of bits set in each block of the filter.
+
+		@return the estimated rate, between 0 and 1
+	*/
+	double false_positive_rate() const
+	{
+		double rate = 0;
+		for (std::size_t b = 0; b < _filter.size(); b += blockWords)
+		{
+			std::size_t ones = 0;
+			for (std::size_t i = b; i < b + blockWords; ++i)
+				ones += std::bitset<64>(_filter[i]).count();
+			rate += std::pow(static_cast<double>(ones) / blockBits, static_cast<double>(_probes));
+		}
+		return rate / (_filter.size() / blockWords);
+	}
+
+
+	/**
+		@brief Get the memory used by the filter
+
+		@return the size in bytes of the filter, the wrapped set excluded
+	*/
+	std::size_t filter_bytes() const
+	{
+		return _filter.size() * sizeof(std::uint64_t);
+	}
+
+
+	/**
+		@brief Swap the content of two sets
+
+		@param other the set whose elements are exchanged with the current set
+	*/
+	void swap(bloom_set& other)
+	{
+		std::swap(_set, other._set);
+		_filter.swap(other._filter);
+		std::swap(_blockBits, other._blockBits);
+		std::swap(_bitsPerElement, other._bitsPerElement);
+		std::swap(_probes, other._probes);
+		std::swap(_capacity, other._capacity);
+		std::swap(_inserted, other._inserted);
+		std::swap(_hash, other._hash);
+	}
+
+
+	/**
+		@brief Get the const_iterator at the beginning of the data sequence
+
+		@return const_iterator at the beginning of the data sequence
+	*/
+	const_iterator begin() const
+	{
+		return _set.begin();
+	}
+
+
+	/**
+		@brief Get the const_iterator at the end of the data sequence
+
+		@return const_iterator at the end of the data sequence
+	*/
+	const_iterator end() const
+	{
+		return _set.end();
+	}
+
+
+	/**
+		@brief Get the bits of filter for each element
+
+		@return the bits per element the filter is sized with
+	*/
+	unsigned int bits_per_element() const
+	{
+		return _bitsPerElement;
+	}
+
+};
+
+/**
+	@brief Stream operator <<
+
+	Overriding of operator<< to write the elements of a bloom_set on a stream.
+
+	@tparam Set the type of the wrapped set
+	@tparam Hash functor used to compute the hash of an element
+	@param os output stream on which an element is sent
+	@param setToPrint the set to be sent on the output stream
+	@return the reference of the output stream
+*/
+template<typename Set, typename Hash>
+std::ostream &operator<<(std::ostream &os, const bloom_set<Set, Hash> &setToPrint)
+{
+	return os << setToPrint.get();
+}
+
+
+/**
+	@brief Filter out the elements of a bloom_set
+
+	@tparam Set the type of the wrapped set
+	@tparam Hash functor used to compute the hash of an element
+	@tparam Pred the predicate that musn't be satisfied
+	@param s the set whose elements will be analyzed and saved if they do NOT satisfy the predicate Pred
+	@return a new set containing the elements of s filtered out
+*/
+template<typename Set, typename Hash, typename Pred>
+bloom_set<Set, Hash> filter_out(const bloom_set<Set, Hash> &s, Pred pred)
+{
+	return bloom_set<Set, Hash>(filter_out(s.get(), pred), s.bits_per_element());
+}
+
+
+/**
+	@brief Create a new bloom_set with the elements of two other sets
+
+	The elements of s2 are checked against the filter of s1, so only the
+	ones the filter cannot rule out are looked for in s1; then the new set
+	is built without looking for duplicates.
+
+	@tparam Set the type of the wrapped set
+	@tparam Hash functor used to compute the hash of an element
+	@param s1 the first set
+	@param s2 the second set
+	@return a new set of elements of s1 and s2
+	@throw duplicated_element_exception if an element appears more than once in the sets
+*/
+template<typename Set, typename Hash>
+bloom_set<Set, Hash> operator+(const bloom_set<Set, Hash> &s1, const bloom_set<Set, Hash> &s2)
+{
+	typedef typename bloom_set<Set, Hash>::value_type T;
+	typedef typename bloom_set<Set, Hash>::const_iterator const_iterator;
+
+	std::vector<const T*> values;
+	values.reserve(static_cast<std::size_t>(s1.size()) + s2.size());
+	for (const_iterator ib = s1.begin(), ie = s1.end(); ib != ie; ++ib)
+		values.push_back(&*ib);
+	for (const_iterator ib = s2.begin(), ie = s2.end(); ib != ie; ++ib)
+	{
+		if (s1.might_contain(*ib) && s1.get().contains(*ib))
+			throw duplicated_element_exception();
+		values.push_back(&*ib);
+	}
+	const T* const* first = values.data();
+	Set merged(indirect_iterator<T>(first), indirect_iterator<T>(first + values.size()), assume_unique);
+	return bloom_set<Set, Hash>(std::move(merged), s1.bits_per_element());
+}
+
+#endif
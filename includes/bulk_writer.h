@@ -0,0 +1,293 @@
+#ifndef BULK_WRITER_H
+#define BULK_WRITER_H
+
+#include <charconv>    // std::to_chars
+#include <cstddef>     // std::size_t
+#include <cstdio>      // std::snprintf
+#include <ostream>     // std::ostream
+#include <streambuf>   // std::streambuf
+#include <string>      // std::string
+#include <type_traits> // std::is_integral, std::is_floating_point, std::is_same, std::enable_if
+#include "student.h"
+
+/**
+	@file bulk_writer.h
+	@brief Declaration of bulk_writer class and of the text formats of the elements
+**/
+
+/**
+	@brief A stream buffer that appends the characters to a string
+
+	It lets operator<< write straight into the buffer of a bulk_writer,
+	with no string of its own in between.
+*/
+class string_appender : public std::streambuf
+{
+
+	std::string* _target; ///< The string the characters are appended to
+
+protected:
+
+	/** Helper function used to append one character */
+	int_type overflow(int_type c) override
+	{
+		if (traits_type::eq_int_type(c, traits_type::eof()))
+			return traits_type::not_eof(c);
+		_target->push_back(traits_type::to_char_type(c));
+		return c;
+	}
+
+	/** Helper function used to append many characters */
+	std::streamsize xsputn(const char_type* s, std::streamsize n) override
+	{
+		_target->append(s, static_cast<std::size_t>(n));
+		return n;
+	}
+
+public:
+
+	/** @brief Constructor, it appends to no string until one is given */
+	string_appender() : _target(0)
+	{}
+
+	/** @brief Set the string the characters are appended to */
+	void target(std::string &out)
+	{
+		_target = &out;
+	}
+};
+
+
+/**
+	@brief Text format of the elements written by a bulk_writer
+
+	A text format appends the text of one element to a buffer; it is
+	specialized for each type of element that can be formatted without
+	a stream. The primary template formats the element with its operator<<
+	through a stream kept by the thread, which appends the text straight
+	to the buffer.
+
+	@tparam T the type of the elements
+*/
+template <typename T, typename = void>
+struct text_format
+{
+	/**
+		@brief Append the text of a value
+
+		@param out the buffer
+		@param value the value to write
+	*/
+	static void append(std::string &out, const T &value)
+	{
+		thread_local string_appender appender;
+		thread_local std::ostream scratch(&appender);
+		appender.target(out);
+		scratch.clear();
+		scratch << value;
+	}
+};
+
+/**
+	@brief Trait telling whether a type is an integer written as a decimal number
+
+	Characters and bools are excluded, since operator<< writes them otherwise.
+*/
+template <typename T>
+struct is_decimal_integer : std::integral_constant<bool, std::is_integral<T>::value && (sizeof(T) > 1)
+	&& !std::is_same<T, wchar_t>::value && !std::is_same<T, char16_t>::value && !std::is_same<T, char32_t>::value>
+{};
+
+/**
+	@brief Text format of integers, written by std::to_chars in place
+*/
+template <typename T>
+struct text_format<T, typename std::enable_if<is_decimal_integer<T>::value>::type>
+{
+	static void append(std::string &out, const T &value)
+	{
+		char digits[24];
+		std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+		out.append(digits, result.ptr);
+	}
+};
+
+/**
+	@brief Text format of floating point numbers, written by std::snprintf in place
+
+	The format is the one of operator<< with the default flags and
+	precision of a stream, %g with 6 significant digits.
+*/
+template <typename T>
+struct text_format<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+	static void append(std::string &out, const T &value)
+	{
+		char digits[32];
+		int length = std::is_same<T, long double>::value
+			? std::snprintf(digits, sizeof(digits), "%Lg", static_cast<long double>(value))
+			: std::snprintf(digits, sizeof(digits), "%g", static_cast<double>(value));
+		out.append(digits, static_cast<std::size_t>(length));
+	}
+};
+
+/**
+	@brief Text format of strings, copied as they are
+*/
+template <>
+struct text_format<std::string>
+{
+	static void append(std::string &out, const std::string &value)
+	{
+		out += value;
+	}
+};
+
+
+/**
+	@brief Text format of students: the same text of operator<<, the name and the age
+*/
+template <>
+struct text_format<student>
+{
+	static void append(std::string &out, const student &value)
+	{
+		out += value.name;
+		out += ' ';
+		text_format<unsigned int>::append(out, value.age);
+	}
+};
+
+
+/**
+	@brief A writer of many elements on a stream
+
+	The elements are formatted into a buffer, each one followed by the
+	delimiter, and the buffer is written on the stream in one call when it
+	is full, when flush is called and when the writer is destroyed.
+	The buffer is allocated once and reused, and the stream is never
+	flushed by the writer, so writing a large set costs a few calls to the
+	stream instead of one call and one flush per element.
+	The elements are formatted by their text_format, the same text of
+	their operator<<.
+*/
+class bulk_writer
+{
+
+	std::ostream &_os;       ///< The stream written
+	std::string _delimiter;  ///< The text written after each element
+	std::string _buffer;     ///< The text not written yet
+	std::size_t _chunk;      ///< The size of the buffer that causes a write
+
+	bulk_writer(const bulk_writer &other); // not copyable
+	bulk_writer& operator=(const bulk_writer &other); // not assignable
+
+public:
+
+	/**
+		@brief Constructor
+
+		@param os the stream to write on
+		@param delimiter the text written after each element
+		@param chunk the number of bytes written at once on the stream
+		@throw std::bad_alloc
+	*/
+	explicit bulk_writer(std::ostream &os, const std::string &delimiter = "\n", std::size_t chunk = 1 << 16)
+		: _os(os), _delimiter(delimiter), _chunk(chunk == 0 ? 1 : chunk)
+	{
+		_buffer.reserve(_chunk + 256);
+	}
+
+
+	/**
+		@brief Destructor
+
+		It writes the text left in the buffer; errors of the stream are
+		left in its state.
+	*/
+	~bulk_writer()
+	{
+		try
+		{
+			flush();
+		}
+		catch (...)
+		{
+			/* the stream keeps its badbit */
+		}
+	}
+
+
+	/**
+		@brief Write an element, followed by the delimiter
+
+		@tparam T the type of the element
+		@param value the element
+		@return a reference to the writer
+	*/
+	template <typename T>
+	bulk_writer& write(const T &value)
+	{
+		text_format<T>::append(_buffer, value);
+		_buffer += _delimiter;
+		if (_buffer.size() >= _chunk)
+			flush();
+		return *this;
+	}
+
+
+	/**
+		@brief Write all the elements of a set, in its order
+
+		@tparam Source the type of the set, or of any range with const_iterator
+		@param s the set
+		@return a reference to the writer
+	*/
+	template <typename Source>
+	bulk_writer& write_all(const Source &s)
+	{
+		for (typename Source::const_iterator ib = s.begin(), ie = s.end(); ib != ie; ++ib)
+			write(*ib);
+		return *this;
+	}
+
+
+	/**
+		@brief Write the buffer on the stream
+
+		The stream itself is not flushed.
+	*/
+	void flush()
+	{
+		if (!_buffer.empty())
+		{
+			_os.write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+			_buffer.clear();
+		}
+	}
+
+};
+
+
+/**
+	@brief Write all the elements of a set on a stream
+
+	It is the same of operator<< with a delimiter, but much faster on large
+	sets: see bulk_writer.
+
+	@tparam Source the type of the set
+	@param os the stream to write on
+	@param s the set
+	@param delimiter the text written after each element
+	@return the reference of the output stream
+*/
+template <typename Source>
+std::ostream& write_all(std::ostream &os, const Source &s, const std::string &delimiter = "\n")
+{
+	bulk_writer writer(os, delimiter);
+	writer.write_all(s);
+	writer.flush();
+	return os;
+}
+
+#endif
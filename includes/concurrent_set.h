@@ -0,0 +1,254 @@
+#ifndef CONCURRENT_SET_H
+#define CONCURRENT_SET_H
+
+#include <cstddef>      // std::size_t
+#include <mutex>        // std::unique_lock
+#include <shared_mutex> // std::shared_mutex, std::shared_lock
+#include <vector>       // std::vector
+#include "set.h"
+#include "non_existent_element_exception.h"
+#include "duplicated_element_exception.h"
+
+/**
+	@file concurrent_set.h
+	@brief Declaration of concurrent_set class
+**/
+
+/**
+	@brief A hashed set that many threads can use at the same time
+
+	The elements are spread over Shards hashed sets by their hash, and each
+	shard has its own reader-writer lock: threads working on different shards
+	never wait for each other, and lookups on the same shard run together.
+	Every member function can be called concurrently with the others.
+	There is no iterator, because the content can change at any time:
+	snapshot gives a consistent copy to iterate over.
+
+	@tparam T the type of the element stored.
+	@tparam Eql functor used to check whether two elements are equal or not.
+	@tparam Hash functor used to compute the hash of an element.
+	@tparam Shards the number of shards, a power of 2.
+*/
+template <typename T, typename Eql, typename Hash, std::size_t Shards = 16>
+class concurrent_set
+{
+	static_assert(Shards > 0 && (Shards & (Shards - 1)) == 0, "the number of shards must be a power of 2");
+
+	/** @brief A shard, on its own cache line so that its lock is not shared with the others */
+	struct alignas(64) shard
+	{
+		mutable std::shared_mutex lock;  ///< taken shared by the lookups, exclusive by the changes
+		set<T, Eql, Hash> elements;      ///< the elements of the shard
+	};
+
+	shard _shards[Shards];  ///< The shards
+	Hash _hash;             ///< Functor used to compute the hash of an element
+
+	concurrent_set(const concurrent_set &other); // not copyable
+	concurrent_set& operator=(const concurrent_set &other); // not assignable
+
+
+	/**
+		Helper function used to pick the shard of a value. The hash is spread
+		with the same multiplicative (Fibonacci) step of set::bucketOf, and
+		the shard is chosen by the log2(Shards) bits of the product starting
+		at bit 32, while the set of the shard takes its bucket from the top
+		bits, from bit 63 down. The two groups of bits don't overlap as long
+		as a shard has at most 2^(32 - log2(Shards)) buckets, 2^28 with 16
+		shards: beyond that the buckets of a shard would share some bits
+		with its index and part of them would stay empty.
+
+		@param value the value
+		@return the shard of value
+	*/
+	shard& shardOf(const T& value)
+	{
+		return _shards[index(value)];
+	}
+
+
+	/** Helper function used to pick the shard of a value */
+	const shard& shardOf(const T& value) const
+	{
+		return _shards[index(value)];
+	}
+
+
+	/** Helper function used to compute the position of the shard of a value */
+	std::size_t index(const T& value) const
+	{
+		if (Shards == 1)
+			return 0;
+		unsigned long long h = static_cast<unsigned long long>(_hash(value)) * 11400714819323198485ull;
+		return static_cast<std::size_t>(h >> 32) & (Shards - 1);
+	}
+
+public:
+
+	/**
+		@brief Default constructor
+
+		It creates an empty set.
+	*/
+	concurrent_set()
+	{}
+
+
+	/**
+		@brief Add an element to the set
+
+		@param val value of the new element
+		@throw duplicated_element_exception
+	*/
+	void add(const T& val)
+	{
+		if (!try_add(val))
+			throw duplicated_element_exception();
+	}
+
+
+	/**
+		@brief Add an element to the set, if it is not there yet
+
+		@param val value of the new element
+		@return true if the element has been added, false if it was already in the set
+	*/
+	bool try_add(const T& val)
+	{
+		shard& s = shardOf(val);
+		std::unique_lock<std::shared_mutex> guard(s.lock);
+		return s.elements.try_add(val);
+	}
+
+
+	/**
+		@brief Add an element to the set moving its value, if it is not there yet
+
+		@param val value of the new element
+		@return true if the element has been added, false if it was already in the set
+	*/
+	bool try_add(T&& val)
+	{
+		shard& s = shardOf(val);
+		std::unique_lock<std::shared_mutex> guard(s.lock);
+		return s.elements.try_add(std::move(val));
+	}
+
+
+	/**
+		@brief Delete an element from the set
+
+		@param toDelete value of the element that has to be deleted
+		@throw non_existent_element_exception
+	*/
+	void remove(const T& toDelete)
+	{
+		if (!try_remove(toDelete))
+			throw non_existent_element_exception();
+	}
+
+
+	/**
+		@brief Delete an element from the set, if it is there
+
+		@param toDelete value of the element that has to be deleted
+		@return true if the element has been removed, false if it was not in the set
+	*/
+	bool try_remove(const T& toDelete)
+	{
+		shard& s = shardOf(toDelete);
+		std::unique_lock<std::shared_mutex> guard(s.lock);
+		return s.elements.try_remove(toDelete);
+	}
+
+
+	/**
+		@brief Check whether a value is in the set
+
+		@param value the value to look for
+		@return true if and only if an element equal to value is in the set
+	*/
+	bool contains(const T& value) const
+	{
+		const shard& s = shardOf(value);
+		std::shared_lock<std::shared_mutex> guard(s.lock);
+		return s.elements.contains(value);
+	}
+
+
+	/**
+		@brief Count the elements equal to a value
+
+		@param value the value to look for
+		@return the number of elements equal to value, either 0 or 1
+	*/
+	unsigned int count(const T& value) const
+	{
+		return contains(value) ? 1 : 0;
+	}
+
+
+	/**
+		@brief Get the number of elements in the set
+
+		The shards are counted one at a time, so while other threads are
+		changing the set the result may match none of its states.
+
+		@return the size of the set
+	*/
+	unsigned int size() const
+	{
+		unsigned int total = 0;
+		for (std::size_t i = 0; i < Shards; ++i)
+		{
+			std::shared_lock<std::shared_mutex> guard(_shards[i].lock);
+			total += _shards[i].elements.size();
+		}
+		return total;
+	}
+
+
+	/**
+		@brief Take a consistent copy of the set
+
+		All the shards are locked for reading, always in the same order, while
+		they are copied: the copy is the content of the set at one instant,
+		and lookups can go on meanwhile. The elements are in shard order.
+
+		@return a set with the elements of the set
+		@throw std::exception
+	*/
+	set<T, Eql, Hash> snapshot() const
+	{
+		std::vector<std::shared_lock<std::shared_mutex> > guards;
+		guards.reserve(Shards);
+		std::size_t total = 0;
+		for (std::size_t i = 0; i < Shards; ++i)
+		{
+			guards.push_back(std::shared_lock<std::shared_mutex>(_shards[i].lock));
+			total += _shards[i].elements.size();
+		}
+		set<T, Eql, Hash> result;
+		result.reserve(total);
+		for (std::size_t i = 0; i < Shards; ++i)
+			result.merge(set<T, Eql, Hash>(_shards[i].elements));
+		return result;
+	}
+
+
+	/**
+		@brief Delete all the elements
+	*/
+	void clear()
+	{
+		for (std::size_t i = 0; i < Shards; ++i)
+		{
+			set<T, Eql, Hash> empty;
+			std::unique_lock<std::shared_mutex> guard(_shards[i].lock);
+			_shards[i].elements.swap(empty);
+		}
+	}
+
+};
+
+#endif
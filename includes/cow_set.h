@@ -0,0 +1,368 @@
+#ifndef COW_SET_H
+#define COW_SET_H
+
+#include <atomic>  // std::atomic_thread_fence
+#include <iterator> // std::iterator_traits
+#include <memory>  // std::shared_ptr, std::make_shared
+#include <ostream> // std::ostream
+#include <utility> // std::move, std::forward
+#include "non_existent_element_exception.h"
+#include "duplicated_element_exception.h"
+
+/**
+	@file cow_set.h
+	@brief Declaration of cow_set class
+**/
+
+/**
+	@brief A set shared by its copies until one of them is changed (copy-on-write)
+
+	It wraps any of the sets (set, flat_set, ordered_set, small_set): copies
+	and assignments only share the wrapped set and take O(1) time, and the
+	wrapped set is copied when a shared copy is changed for the first time.
+	The sharing is counted by a std::shared_ptr, so copies can be handed to
+	other threads and read or changed there, each copy by one thread at a time.
+	Iterators and references taken from a copy are valid until that copy
+	is changed.
+
+	@tparam Set the type of the wrapped set
+*/
+template <typename Set>
+class cow_set
+{
+
+	std::shared_ptr<Set> _data; ///< The wrapped set, shared by the copies; 0 if empty and never changed
+
+	/**
+		Helper function used to get the wrapped set, or an empty one.
+
+		@return the wrapped set
+	*/
+	const Set& data() const
+	{
+		static const Set empty;
+		return _data ? *_data : empty;
+	}
+
+
+	/**
+		Helper function used to make the wrapped set owned by this copy only,
+		copying it if it is shared, before it is changed.
+
+		@return the wrapped set, which can be changed
+	*/
+	Set& detach()
+	{
+		if (!_data)
+			_data = std::make_shared<Set>();
+		else if (_data.use_count() != 1)
+			_data = std::make_shared<Set>(*_data);
+		else
+		{
+			// the reads of the copies released by other threads must be
+			// finished before the set is changed
+			std::atomic_thread_fence(std::memory_order_acquire);
+		}
+		return *_data;
+	}
+
+public:
+
+	/// The iterator of the wrapped set
+	typedef typename Set::const_iterator const_iterator;
+
+	/// The type of the elements
+	typedef typename std::iterator_traits<const_iterator>::value_type value_type;
+
+	/**
+		@brief Default constructor
+
+		It creates an empty set, with no allocation.
+	*/
+	cow_set()
+	{}
+
+
+	/**
+		@brief Constructor from a set
+
+		@param s the set to be wrapped, copied
+		@throw std::exception
+	*/
+	explicit cow_set(const Set &s) : _data(std::make_shared<Set>(s))
+	{}
+
+
+	/**
+		@brief Constructor from a temporary set
+
+		@param s the set to be wrapped, moved
+		@throw std::exception
+	*/
+	explicit cow_set(Set &&s) : _data(std::make_shared<Set>(std::move(s)))
+	{}
+
+
+	/**
+		@brief Get the wrapped set
+
+		@return a reference to the wrapped set, valid until the set is changed
+	*/
+	const Set& get() const
+	{
+		return data();
+	}
+
+
+	/**
+		@brief Check whether the wrapped set is shared with other copies
+
+		@return true if and only if a change would copy the wrapped set
+	*/
+	bool is_shared() const
+	{
+		return _data && _data.use_count() != 1;
+	}
+
+
+	/**
+		@brief Add an element to the set
+
+		If the element is already in the set, the exception is thrown
+		without copying the wrapped set.
+
+		@param val value of the new element
+		@throw duplicated_element_exception
+	*/
+	void add(const value_type& val)
+	{
+		if (data().contains(val))
+			throw duplicated_element_exception();
+		detach().add(val);
+	}
+
+
+	/**
+		@brief Add an element to the set, moving its value
+
+		@param val value of the new element
+		@throw duplicated_element_exception
+	*/
+	void add(value_type&& val)
+	{
+		if (data().contains(val))
+			throw duplicated_element_exception();
+		detach().add(std::move(val));
+	}
+
+
+	/**
+		@brief Add an element to the set, if it is not there yet
+
+		The wrapped set is not copied if the element is already in it.
+
+		@param val value of the new element
+		@return true if the element has been added, false if it was already in the set
+	*/
+	bool try_add(const value_type& val)
+	{
+		return !data().contains(val) && detach().try_add(val);
+	}
+
+
+	/**
+		@brief Add an element to the set moving its value, if it is not there yet
+
+		@param val value of the new element
+		@return true if the element has been added, false if it was already in the set
+	*/
+	bool try_add(value_type&& val)
+	{
+		return !data().contains(val) && detach().try_add(std::move(val));
+	}
+
+
+	/**
+		@brief Build an element in place and add it to the set
+
+		@tparam Args the types of the arguments
+		@param args the arguments passed to a constructor of the elements
+		@throw duplicated_element_exception
+	*/
+	template <typename... Args>
+	void emplace(Args&&... args)
+	{
+		detach().emplace(std::forward<Args>(args)...);
+	}
+
+
+	/**
+		@brief Delete an element from the set
+
+		If the element is not in the set, the exception is thrown
+		without copying the wrapped set.
+
+		@param toDelete value of the element that has to be deleted
+		@throw non_existent_element_exception
+	*/
+	void remove(const value_type& toDelete)
+	{
+		if (!data().contains(toDelete))
+			throw non_existent_element_exception();
+		detach().remove(toDelete);
+	}
+
+
+	/**
+		@brief Delete an element from the set, if it is there
+
+		@param toDelete value of the element that has to be deleted
+		@return true if the element has been removed, false if it was not in the set
+	*/
+	bool try_remove(const value_type& toDelete)
+	{
+		return data().contains(toDelete) && detach().try_remove(toDelete);
+	}
+
+
+	/**
+		@brief Get the element at a position
+
+		@param i the position of the element
+		@return the element at position i
+	*/
+	const value_type& operator[](unsigned int i) const
+	{
+		return data()[i];
+	}
+
+
+	/**
+		@brief Get the number of elements in the set
+
+		@return the size of the set
+	*/
+	unsigned int size() const
+	{
+		return data().size();
+	}
+
+
+	/**
+		@brief Check whether a value is in the set
+
+		@param value the value to look for
+		@return true if and only if an element equal to value is in the set
+	*/
+	bool contains(const value_type& value) const
+	{
+		return data().contains(value);
+	}
+
+
+	/**
+		@brief Find a value in the set
+
+		@param value the value to look for
+		@return const_iterator to the element, or end() if there is none
+	*/
+	const_iterator find(const value_type& value) const
+	{
+		return data().find(value);
+	}
+
+
+	/**
+		@brief Count the elements equal to a value
+
+		@param value the value to look for
+		@return the number of elements equal to value, either 0 or 1
+	*/
+	unsigned int count(const value_type& value) const
+	{
+		return data().count(value);
+	}
+
+
+	/**
+		@brief Swap the content of two sets
+
+		@param other the set whose elements are exchanged with the current set
+	*/
+	void swap(cow_set& other)
+	{
+		_data.swap(other._data);
+	}
+
+
+	/**
+		@brief Get the const_iterator at the beginning of the data sequence
+
+		@return const_iterator at the beginning of the data sequence
+	*/
+	const_iterator begin() const
+	{
+		return data().begin();
+	}
+
+
+	/**
+		@brief Get the const_iterator at the end of the data sequence
+
+		@return const_iterator at the end of the data sequence
+	*/
+	const_iterator end() const
+	{
+		return data().end();
+	}
+
+};
+
+/**
+	@brief Stream operator <<
+
+	Overriding of operator<< to write the elements of a cow_set on a stream.
+
+	@tparam Set the type of the wrapped set
+	@param os output stream on which an element is sent
+	@param setToPrint the set to be sent on the output stream
+	@return the reference of the output stream
+*/
+template<typename Set>
+std::ostream &operator<<(std::ostream &os, const cow_set<Set> &setToPrint)
+{
+	return os << setToPrint.get();
+}
+
+
+/**
+	@brief Filter out the elements of a cow_set
+
+	@tparam Set the type of the wrapped set
+	@tparam Pred the predicate that musn't be satisfied
+	@param s the set whose elements will be analyzed and saved if they do NOT satisfy the predicate Pred
+	@return a new set containing the elements of s filtered out
+*/
+template<typename Set, typename Pred>
+cow_set<Set> filter_out(const cow_set<Set> &s, Pred pred)
+{
+	return cow_set<Set>(filter_out(s.get(), pred));
+}
+
+
+/**
+	@brief Create a new cow_set with the elements of two other sets
+
+	@tparam Set the type of the wrapped set
+	@param s1 the first set
+	@param s2 the second set
+	@return a new set of elements of s1 and s2
+	@throw duplicated_element_exception if an element appears more than once in the sets
+*/
+template<typename Set>
+cow_set<Set> operator+(const cow_set<Set> &s1, const cow_set<Set> &s2)
+{
+	return cow_set<Set>(s1.get() + s2.get());
+}
+
+#endif
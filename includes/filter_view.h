@@ -0,0 +1,353 @@
+#ifndef FILTER_VIEW_H
+#define FILTER_VIEW_H
+
+#include <iterator>    // std::forward_iterator_tag, std::iterator_traits
+#include <cstddef>     // std::ptrdiff_t
+#include <type_traits> // std::false_type, std::true_type, std::enable_if, std::is_same
+#include <utility>     // std::move, std::declval
+
+/**
+	@file filter_view.h
+	@brief Declaration of filter_view class and of the filtered_out adaptor
+**/
+
+/**
+	@brief Tag stating that a range holds no duplicated elements
+
+	It can be passed to the range constructors of the sets, which then
+	trust the range and append its elements without looking for duplicates.
+	Passing a range with duplicates breaks the set.
+*/
+struct assume_unique_t
+{};
+
+/// Value of the assume_unique_t tag
+inline constexpr assume_unique_t assume_unique = assume_unique_t();
+
+
+/**
+	@brief Check whether a container is ordered by a comparison functor
+
+	It is true for containers with a key_comp() member function, like
+	ordered_set.
+
+	@tparam C the type of the container
+*/
+template <typename C, typename = void>
+struct has_key_comp : std::false_type
+{};
+
+template <typename C>
+struct has_key_comp<C, decltype(void(std::declval<const C&>().key_comp()))> : std::true_type
+{};
+
+
+/**
+	@brief Build a container from unique elements taken from another one
+
+	The elements are appended with assume_unique. If both containers are
+	ordered by the same type of comparison functor, the new one gets a
+	copy of the functor of source, so that a functor holding a state
+	orders the new container as it orders source.
+
+	@tparam Result the type of the new container
+	@tparam Source the type of the container the elements come from
+	@tparam Q the type of the iterator
+	@param source the container the elements come from
+	@param b begin iterator
+	@param e end iterator
+	@return the new container
+	@throw std::exception
+*/
+template <typename Result, typename Source, typename Q>
+Result build_unique(const Source &source, Q b, Q e)
+{
+	if constexpr (has_key_comp<Source>::value && has_key_comp<Result>::value)
+	{
+		if constexpr (std::is_same<decltype(source.key_comp()), decltype(std::declval<const Result&>().key_comp())>::value)
+			return Result(b, e, assume_unique, source.key_comp());
+		else
+			return Result(b, e, assume_unique);
+	}
+	else
+		return Result(b, e, assume_unique);
+}
+
+
+/**
+	@brief A predicate satisfied when any of two predicates is satisfied
+
+	It is how filter views chain their predicates.
+
+	@tparam P the first predicate
+	@tparam Q the second predicate
+*/
+template <typename P, typename Q>
+struct either_of
+{
+	P first;   ///< the first predicate
+	Q second;  ///< the second predicate, checked only if the first one fails
+
+	/** @brief Check whether value satisfies first or second */
+	template <typename T>
+	bool operator()(const T& value) const
+	{
+		return first(value) || second(value);
+	}
+};
+
+
+/**
+	@brief Request to filter out the elements satisfying a predicate
+
+	It is what filtered_out returns and what a container or a view is
+	piped into: s | filtered_out(p).
+
+	@tparam Pred the predicate
+*/
+template <typename Pred>
+struct filtered_out_t
+{
+	Pred pred; ///< elements satisfying it are left out
+};
+
+
+/**
+	@brief Build a request to filter out the elements satisfying pred
+
+	@tparam Pred the type of the predicate
+	@param pred the predicate
+	@return the request, to be piped after a set or a view
+*/
+template <typename Pred>
+filtered_out_t<Pred> filtered_out(Pred pred)
+{
+	filtered_out_t<Pred> request = { std::move(pred) };
+	return request;
+}
+
+
+/**
+	@brief A lazy view of the elements of a container not satisfying a predicate
+
+	The view refers to the container, which must outlive it, and copies
+	nothing: the predicate is checked while iterating, so the view always
+	shows the current content of the container.
+	More predicates are chained by piping the view into filtered_out again.
+
+	@tparam Source the type of the container, a set, a flat_set or an ordered_set
+	@tparam Pred the predicate that musn't be satisfied
+*/
+template <typename Source, typename Pred>
+class filter_view
+{
+
+	const Source* _source; ///< The filtered container
+	Pred _pred;            ///< Elements satisfying it are left out
+
+public:
+
+	/**
+		@brief Constructor
+
+		@param source the container to filter
+		@param pred the predicate that musn't be satisfied
+	*/
+	filter_view(const Source &source, Pred pred) : _source(&source), _pred(std::move(pred))
+	{}
+
+
+	/** @brief Get the filtered container */
+	const Source& source() const
+	{
+		return *_source;
+	}
+
+
+	/** @brief Get the predicate of the view */
+	const Pred& predicate() const
+	{
+		return _pred;
+	}
+
+
+	/**
+		@brief Forward iterator on the elements of the view
+
+		It walks the container, skipping the elements that satisfy the predicate.
+	*/
+	class const_iterator
+	{
+
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef typename std::iterator_traits<typename Source::const_iterator>::value_type value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const value_type* pointer;
+		typedef const value_type& reference;
+
+		const_iterator() : _pred(0)
+		{}
+
+		reference operator*() const
+		{
+			return *_current;
+		}
+
+		pointer operator->() const
+		{
+			return &*_current;
+		}
+
+		const_iterator& operator++()
+		{
+			++_current;
+			skip();
+			return *this;
+		}
+
+		const_iterator operator++(int)
+		{
+			const_iterator tmp(*this);
+			++*this;
+			return tmp;
+		}
+
+		bool operator==(const const_iterator &other) const
+		{
+			return _current == other._current;
+		}
+
+		bool operator!=(const const_iterator &other) const
+		{
+			return _current != other._current;
+		}
+
+	private:
+
+		typename Source::const_iterator _current; ///< The current element of the container
+		typename Source::const_iterator _end;     ///< The end of the container
+		const Pred* _pred;                        ///< The predicate of the view
+
+		// The view must be friend of the iterator to allow it to call
+		// the private constructor
+		friend class filter_view;
+
+		const_iterator(typename Source::const_iterator current, typename Source::const_iterator end, const Pred* pred)
+			: _current(current), _end(end), _pred(pred)
+		{
+			skip();
+		}
+
+		/** Move forward to the first element not satisfying the predicate */
+		void skip()
+		{
+			while (_current != _end && (*_pred)(*_current))
+				++_current;
+		}
+	};
+
+
+	/** @brief Return an iterator to the first element of the view */
+	const_iterator begin() const
+	{
+		return const_iterator(_source->begin(), _source->end(), &_pred);
+	}
+
+
+	/** @brief Return an iterator to the end of the view */
+	const_iterator end() const
+	{
+		return const_iterator(_source->end(), _source->end(), &_pred);
+	}
+
+
+	/**
+		@brief Check whether the view has no elements
+
+		It stops at the first element not filtered out.
+	*/
+	bool empty() const
+	{
+		return begin() == end();
+	}
+
+
+	/**
+		@brief Copy the elements of the view into a new container
+
+		The elements of a set are unique, so they are appended without
+		looking for duplicates. An ordered container keeps the comparison
+		functor of the source, see build_unique.
+
+		@tparam Result the type of the new container, by default the same as the source
+		@return a new container with the elements of the view
+		@throw std::exception
+	*/
+	template <typename Result = Source>
+	Result materialize() const
+	{
+		return build_unique<Result>(*_source, begin(), end());
+	}
+};
+
+
+/**
+	@brief Check whether a type is a filter_view
+
+	@tparam V the type to check
+*/
+template <typename V>
+struct is_filter_view : std::false_type
+{};
+
+template <typename Source, typename Pred>
+struct is_filter_view<filter_view<Source, Pred> > : std::true_type
+{};
+
+
+/**
+	@brief Build a lazy view of the elements of s not satisfying a predicate
+
+	@tparam Source the type of the container
+	@tparam Pred the type of the predicate
+	@param s the container, it must outlive the view
+	@param request the request built by filtered_out
+	@return the view
+*/
+template <typename Source, typename Pred, typename = typename std::enable_if<!is_filter_view<Source>::value>::type>
+filter_view<Source, Pred> operator|(const Source &s, filtered_out_t<Pred> request)
+{
+	return filter_view<Source, Pred>(s, std::move(request.pred));
+}
+
+
+/**
+	A view of a temporary container would be left dangling,
+	so it cannot be built.
+*/
+template <typename Source, typename Pred, typename = typename std::enable_if<!is_filter_view<Source>::value>::type>
+void operator|(const Source &&s, filtered_out_t<Pred> request) = delete;
+
+
+/**
+	@brief Chain one more predicate to a view
+
+	The new view leaves out the elements satisfying either its predicate
+	or the predicate of v. No element is visited.
+
+	@tparam Source the type of the container
+	@tparam Pred the type of the predicate of v
+	@tparam Next the type of the new predicate
+	@param v the view
+	@param request the request built by filtered_out
+	@return the new view
+*/
+template <typename Source, typename Pred, typename Next>
+filter_view<Source, either_of<Pred, Next> > operator|(const filter_view<Source, Pred> &v, filtered_out_t<Next> request)
+{
+	either_of<Pred, Next> both = { v.predicate(), std::move(request.pred) };
+	return filter_view<Source, either_of<Pred, Next> >(v.source(), both);
+}
+
+#endif
@@ -0,0 +1,854 @@
+#ifndef FLAT_SET_H
+#define FLAT_SET_H
+
+#include <cassert>     // assert()
+#include <cstddef>     // std::size_t
+#include <cstdint>     // std::uint32_t, std::uint64_t
+#include <ostream>     // std::ostream
+#include <type_traits> // std::is_same
+#include <utility>     // std::move
+#include <vector>      // std::vector
+#include "set.h"
+#include "simd_find.h"
+#include "set_stats.h"
+#include "non_existent_element_exception.h"
+#include "duplicated_element_exception.h"
+
+/**
+	@file flat_set.h
+	@brief Declaration of flat_set class
+**/
+
+/**
+	@brief A dynamic set of elements stored contiguously.
+
+	It has the same interface of set, but the elements are kept one after the
+	other in a single array, so iterating over them reads memory sequentially
+	and operator[] takes constant time.
+	If a hash functor is given as Hash, the positions of the elements are
+	also kept in an open addressing hash table (linear probing), so add,
+	remove and lookups take average O(1) time; otherwise lookups scan the array.
+	The scan compares many elements per instruction when T is arithmetic 
+	and Eql is its built-in equality (see is_builtin_equality).
+
+	The elements are kept in insertion order, except that remove moves
+	the last element into the position of the removed one.
+	A copy clones the array and the hash table as they are, with no 
+	duplicate checks nor rehashing: for trivially copyable T each of them 
+	is copied in bulk by std::vector, with a single memmove.
+
+	@tparam T the type of the element stored.
+	@tparam Eql functor used to check whether two elements are equal or not.
+	@tparam Hash functor used to compute the hash of an element (no_hash for no index).
+*/
+template <typename T, typename Eql, typename Hash = no_hash<T> >
+class flat_set
+{
+
+	/// true if and only if the set keeps a hash index of its elements
+	static const bool hashed = !std::is_same<Hash, no_hash<T> >::value;
+
+	/// true if and only if the array is scanned with simd_find
+	static const bool vectorized = !hashed && is_builtin_equality<Eql, T>::value && is_simd_comparable<T>::value;
+
+	/// value returned by the lookups that find nothing
+	static const std::size_t npos = static_cast<std::size_t>(-1);
+
+	/**
+		@brief A slot of the hash table
+
+		An empty slot has position 0. The tag lets most of the slots of other
+		elements be skipped without reading the elements themselves.
+	*/
+	struct slot
+	{
+		std::uint32_t position; ///< position of the element in the array plus one
+		std::uint32_t tag;      ///< the tag of the element
+
+		/** @brief Default constructor, it creates an empty slot */
+		slot() : position(0), tag(0)
+		{}
+	};
+
+	std::vector<T> _values;             ///< The elements, contiguously
+	std::vector<std::uint32_t> _tags;   ///< The tags of the elements (only if hashed)
+	std::vector<slot> _slots;           ///< The hash table, 0 or a power of 2 slots (only if hashed)
+	unsigned int _slotBits;             ///< log2 of the number of slots
+
+	Eql _equal;                 ///< Functor used to check whether two elements are equal or not
+	Hash _hash;                 ///< Functor used to compute the hash of an element
+
+
+	/**
+		Helper function used to compute the tag of a value: the high 32 bits
+		of its hash spread with a multiplicative (Fibonacci) step.
+
+		@param value the value
+		@return the tag of value
+	*/
+	std::uint32_t tagOf(const T& value) const
+	{
+		std::uint64_t spread = static_cast<std::uint64_t>(_hash(value)) * 11400714819323198485ull;
+		return static_cast<std::uint32_t>(spread >> 32);
+	}
+
+
+	/**
+		Helper function used to get the first slot where a tag is looked for.
+
+		@pre the table has at least one slot
+		@param tag the tag of a value
+		@return the position of the slot
+	*/
+	std::size_t home(std::uint32_t tag) const
+	{
+		return _slotBits == 0 ? 0 : tag >> (32 - _slotBits);
+	}
+
+
+	/**
+		Helper function used to get the slot after another one, wrapping around.
+
+		@param i the position of a slot
+		@return the position of the following slot
+	*/
+	std::size_t following(std::size_t i) const
+	{
+		return (i + 1) & (_slots.size() - 1);
+	}
+
+
+	/**
+		Helper function used to look up a value in the hash table.
+
+		@param value the value to look for
+		@param tag the tag of value
+		@return the position of the slot of value, or npos if there is none
+	*/
+	std::size_t lookup(const T& value, std::uint32_t tag) const
+	{
+		if (_slots.empty())
+			return npos;
+		for (std::size_t i = home(tag); _slots[i].position != 0; i = following(i))
+		{
+			if (_slots[i].tag == tag && _equal(value, _values[_slots[i].position - 1]))
+				return i;
+		}
+		return npos;
+	}
+
+
+	/**
+		Helper function used to look up the slot of a position of the array.
+
+		@param position the position of an element in the array
+		@return the position of the slot of the element
+	*/
+	std::size_t slotOf(std::size_t position) const
+	{
+		std::size_t i = home(_tags[position]);
+		while (_slots[i].position != position + 1)
+			i = following(i);
+		return i;
+	}
+
+
+	/**
+		Helper function used to put a position in the first free slot for its tag.
+
+		@param position the position of an element in the array
+	*/
+	void place(std::size_t position)
+	{
+		std::uint32_t tag = _tags[position];
+		std::size_t i = home(tag);
+		while (_slots[i].position != 0)
+			i = following(i);
+		_slots[i].position = static_cast<std::uint32_t>(position + 1);
+		_slots[i].tag = tag;
+	}
+
+
+	/**
+		Helper function used to empty a slot. The following slots of the same
+		run are shifted back, so that no lookup stops too early.
+
+		@param hole the position of the slot to be emptied
+	*/
+	void erase(std::size_t hole)
+	{
+		for (std::size_t i = following(hole); _slots[i].position != 0; i = following(i))
+		{
+			std::size_t h = home(_slots[i].tag);
+			// the slot can fill the hole if its home is not in (hole, i]
+			bool stays = (hole < i) ? (hole < h && h <= i) : (hole < h || h <= i);
+			if (!stays)
+			{
+				_slots[hole] = _slots[i];
+				hole = i;
+			}
+		}
+		_slots[hole] = slot();
+	}
+
+
+	/**
+		Helper function used to resize the hash table, so that it has at least
+		count slots. All the elements are placed again.
+
+		@param count the minimum number of slots
+	*/
+	void rehash(std::size_t count)
+	{
+		unsigned int bits = 0;
+		while ((std::size_t(1) << bits) < count)
+			++bits;
+		_slots.assign(std::size_t(1) << bits, slot());
+		_slotBits = bits;
+		for (std::size_t i = 0; i < _values.size(); ++i)
+			place(i);
+	}
+
+
+	/**
+		Helper function used to check that the last element of the array is
+		not a duplicate and to index it. If it is a duplicate, it is removed
+		and an exception is thrown.
+	*/
+	void admitLast()
+	{
+		std::size_t last = _values.size() - 1;
+		try
+		{
+			if constexpr (hashed)
+			{
+				std::uint32_t tag = tagOf(_values[last]);
+				if (lookup(_values[last], tag) != npos)
+					throw duplicated_element_exception();
+				assert(_values.size() < 0xFFFFFFFFu);
+				_tags.push_back(tag);
+				if (_values.size() * 4 > _slots.size() * 3)
+					rehash(_slots.empty() ? 16 : _slots.size() * 2);
+				else
+					place(last);
+			}
+			else if constexpr (vectorized)
+			{
+				if (simd_find(_values.data(), last, _values[last]) != last)
+					throw duplicated_element_exception();
+			}
+			else
+			{
+				for (std::size_t i = 0; i < last; ++i)
+					if (_equal(_values[last], _values[i]))
+						throw duplicated_element_exception();
+			}
+		}
+		catch (...)
+		{
+			if constexpr (hashed)
+				_tags.resize(last);
+			_values.pop_back();
+			throw;
+		}
+	}
+
+
+	/**
+		Helper function used to add an element to the set.
+		The duplicates are looked for before the array is touched.
+
+		@tparam V the type of the value, a reference to T
+		@param newValue the value of the new element to be inserted, copied or moved
+		@return true if the element has been added, false if it was a duplicate
+	*/
+	template <typename V>
+	bool insert(V&& newValue)
+	{
+		if constexpr (hashed)
+		{
+			std::uint32_t tag = tagOf(newValue);
+			if (lookup(newValue, tag) != npos)
+				return false;
+			assert(_values.size() < 0xFFFFFFFFu);
+			if ((_values.size() + 1) * 4 > _slots.size() * 3)
+				rehash(_slots.empty() ? 16 : _slots.size() * 2);
+			_values.push_back(std::forward<V>(newValue));
+			try
+			{
+				_tags.push_back(tag);
+			}
+			catch (...)
+			{
+				_values.pop_back();
+				throw;
+			}
+			place(_values.size() - 1);
+		}
+		else
+		{
+			if (position(newValue) != npos)
+				return false;
+			_values.push_back(std::forward<V>(newValue));
+		}
+		return true;
+	}
+
+
+	/**
+		Helper function used to look up the position of a value in the array.
+
+		@param value the value to look for
+		@return the position of value, or npos if there is none
+	*/
+	std::size_t position(const T& value) const
+	{
+		if constexpr (hashed)
+		{
+			std::size_t i = lookup(value, tagOf(value));
+			return i == npos ? npos : _slots[i].position - 1;
+		}
+		else if constexpr (vectorized)
+		{
+			std::size_t i = simd_find(_values.data(), _values.size(), value);
+			return i == _values.size() ? npos : i;
+		}
+		else
+		{
+			for (std::size_t i = 0; i < _values.size(); ++i)
+				if (_equal(value, _values[i]))
+					return i;
+			return npos;
+		}
+	}
+
+public:
+
+	/**
+		@brief Random access const_iterator of the class
+
+		It is used to iterate over the elements of the set.
+	*/
+	typedef typename std::vector<T>::const_iterator const_iterator;
+
+
+	/**
+		@brief Default constructor
+
+		It is used to create a new empty set.
+	*/
+	flat_set() : _slotBits(0)
+	{}
+
+
+	/**
+		@brief Secondary constructor
+
+		It creates a set using a data sequence defined by a generic
+		pair of iterators. If the sequence can be counted beforehand,
+		the storage is allocated once for all the elements.
+
+		@tparam Q the type of the iterator
+		@param b begin iterator
+		@param e end iterator
+		@throw duplicated_element_exception
+		@throw std::exception
+	*/
+	template <typename Q>
+	flat_set(Q b, Q e) : _slotBits(0)
+	{
+		reserve(range_size_hint(b, e));
+		while (b != e)
+		{
+			add(static_cast<T>(*b));
+			++b;
+		}
+	}
+
+
+	/**
+		@brief Secondary constructor, skipping duplicates
+
+		It creates a set using a data sequence defined by a generic
+		pair of iterators. Only the first occurrence of each value is kept.
+
+		@tparam Q the type of the iterator
+		@param b begin iterator
+		@param e end iterator
+		@throw std::exception
+	*/
+	template <typename Q>
+	flat_set(Q b, Q e, insert_or_ignore_t) : _slotBits(0)
+	{
+		reserve(range_size_hint(b, e));
+		while (b != e)
+		{
+			insert(static_cast<T>(*b));
+			++b;
+		}
+	}
+
+
+	/**
+		@brief Secondary constructor, trusting the range to have no duplicates
+
+		It creates a set using a data sequence defined by a generic
+		pair of iterators, such as a filter_view of another set, whose
+		elements are known to be unique: they are stored without looking 
+		for duplicates and the hash table is built once at the end.
+
+		@tparam Q the type of the iterator
+		@param b begin iterator
+		@param e end iterator
+		@throw std::exception
+	*/
+	template <typename Q>
+	flat_set(Q b, Q e, assume_unique_t) : _slotBits(0)
+	{
+		_values.reserve(range_size_hint(b, e));
+		while (b != e)
+		{
+			_values.push_back(static_cast<T>(*b));
+			++b;
+		}
+		if constexpr (hashed)
+		{
+			assert(_values.size() < 0xFFFFFFFFu);
+			if (!_values.empty())
+			{
+				_tags.reserve(_values.size());
+				for (std::size_t i = 0; i < _values.size(); ++i)
+					_tags.push_back(tagOf(_values[i]));
+				rehash((_values.size() * 4 + 2) / 3);
+			}
+		}
+	}
+
+
+	/**
+		@brief Prepare the set for a number of elements
+
+		The storage and, if the set is hashed, the hash table are grown 
+		so that count elements fit without reallocating them.
+
+		@param count the number of elements expected in the set
+	*/
+	void reserve(std::size_t count)
+	{
+		_values.reserve(count);
+		if constexpr (hashed)
+		{
+			_tags.reserve(count);
+			if (count * 4 > _slots.size() * 3)
+				rehash((count * 4 + 2) / 3);
+		}
+	}
+
+
+	/**
+		@brief Add an element to the set
+
+		It adds a new element at the end of the set with the value in input.
+
+		@param val value of the new element
+		@throw duplicated_element_exception
+	*/
+	void add(const T& val)
+	{
+		if (!insert(val))
+			throw duplicated_element_exception();
+	}
+
+
+	/**
+		@brief Add an element to the set, moving its value
+
+		@param val value of the new element
+		@throw duplicated_element_exception
+	*/
+	void add(T&& val)
+	{
+		if (!insert(std::move(val)))
+			throw duplicated_element_exception();
+	}
+
+
+	/**
+		@brief Add an element to the set, if it is not there yet
+
+		@param val value of the new element
+		@return true if the element has been added, false if it was already in the set
+	*/
+	bool try_add(const T& val)
+	{
+		return insert(val);
+	}
+
+
+	/**
+		@brief Add an element to the set moving its value, if it is not there yet
+
+		@param val value of the new element
+		@return true if the element has been added, false if it was already in the set
+	*/
+	bool try_add(T&& val)
+	{
+		return insert(std::move(val));
+	}
+
+
+	/**
+		@brief Build an element in place and add it to the set
+
+		@tparam Args the types of the arguments
+		@param args the arguments passed to a constructor of T
+		@throw duplicated_element_exception
+	*/
+	template <typename... Args>
+	void emplace(Args&&... args)
+	{
+		_values.emplace_back(std::forward<Args>(args)...);
+		admitLast();
+	}
+
+
+	/**
+		@brief Delete an element from the set
+
+		It removes from the set the element whose value corresponds to the
+		value toDelete in input. The last element of the set takes its position.
+
+		@param toDelete value of the element that has to be deleted
+		@throw non_existent_element_exception
+	*/
+	void remove(const T& toDelete)
+	{
+		if (!try_remove(toDelete))
+			throw non_existent_element_exception();
+	}
+
+
+	/**
+		@brief Delete an element from the set, if it is there
+
+		@param toDelete value of the element that has to be deleted
+		@return true if the element has been removed, false if it was not in the set
+	*/
+	bool try_remove(const T& toDelete)
+	{
+		std::size_t last = _values.size() - 1;
+		std::size_t removed;
+		if constexpr (hashed)
+		{
+			std::size_t i = lookup(toDelete, tagOf(toDelete));
+			if (i == npos)
+				return false;
+			removed = _slots[i].position - 1;
+			erase(i);
+			if (removed != last)
+			{
+				_slots[slotOf(last)].position = static_cast<std::uint32_t>(removed + 1);
+				_tags[removed] = _tags[last];
+			}
+			_tags.pop_back();
+		}
+		else
+		{
+			removed = position(toDelete);
+			if (removed == npos)
+				return false;
+		}
+		if (removed != last)
+			_values[removed] = std::move(_values[last]);
+		_values.pop_back();
+		return true;
+	}
+
+
+	/**
+		@brief Get an element from the set
+
+		It gets the i-th element of the set in constant time.
+		The first element is at position 0.
+		The last element  is at position size − 1.
+
+		@pre it is necessary that i < size
+		@param i index of the element in the set
+		@return the value of the element in i-th position
+	*/
+	const T& operator[](unsigned int i) const
+	{
+		assert(i < _values.size());
+		return _values[i];
+	}
+
+
+	/**
+		@brief Get the number of elements in the set
+
+		@return the size of the set
+	*/
+	unsigned int size() const
+	{
+		return static_cast<unsigned int>(_values.size());
+	}
+
+
+	/**
+		@brief Get the memory and structure statistics of the set
+
+		The unused capacity of the arrays is counted as fragmentation.
+		It takes O(n) time, finding the slot of each element.
+
+		@return the statistics
+	*/
+	set_stats stats() const
+	{
+		set_stats result;
+		result.elements = _values.size();
+		result.element_bytes = sizeof(T) + (hashed ? sizeof(std::uint32_t) : 0);
+		result.storage_bytes = _values.capacity() * sizeof(T) + _tags.capacity() * sizeof(std::uint32_t);
+		result.index_bytes = _slots.size() * sizeof(slot);
+		result.allocated_bytes = result.storage_bytes + result.index_bytes;
+		std::size_t used = result.elements * result.element_bytes + result.index_bytes;
+		if (result.allocated_bytes > used)
+			result.fragmentation = 1.0 - static_cast<double>(used) / result.allocated_bytes;
+		if (result.elements != 0)
+			result.bytes_per_element = static_cast<double>(result.allocated_bytes) / result.elements;
+
+		if constexpr (hashed)
+		{
+			result.hashed = true;
+			result.buckets = _slots.size();
+			if (!_slots.empty())
+				result.load_factor = static_cast<double>(_values.size()) / _slots.size();
+			for (std::size_t p = 0; p < _values.size(); ++p)
+			{
+				std::size_t probes = ((slotOf(p) - home(_tags[p])) & (_slots.size() - 1)) + 1;
+				if (probes > result.probe_lengths.size())
+					result.probe_lengths.resize(probes, 0);
+				++result.probe_lengths[probes - 1];
+				if (probes > result.longest_chain)
+					result.longest_chain = probes;
+			}
+		}
+		return result;
+	}
+
+
+	/**
+		@brief Write a debug dump of the set
+
+		It writes the statistics and, if the set is hashed, the first 
+		non-empty slots of the hash table, each with its element and the
+		slot where its probes start.
+
+		@param os the output stream
+		@param slots the number of non-empty slots to write
+	*/
+	void dump(std::ostream &os, std::size_t slots = 16) const
+	{
+		os << stats();
+		if constexpr (hashed)
+		{
+			for (std::size_t i = 0; i < _slots.size() && slots != 0; ++i)
+			{
+				if (_slots[i].position == 0)
+					continue;
+				os << "slot " << i << ": " << _values[_slots[i].position - 1] << " (home " << home(_slots[i].tag) << ")\n";
+				--slots;
+			}
+		}
+	}
+
+
+	/**
+		@brief Check whether a value is in the set
+
+		@param value the value to look for
+		@return true if and only if an element equal to value is in the set
+	*/
+	bool contains(const T& value) const
+	{
+		return position(value) != npos;
+	}
+
+
+	/**
+		@brief Find a value in the set
+
+		@param value the value to look for
+		@return const_iterator to the element, or end() if there is none
+	*/
+	const_iterator find(const T& value) const
+	{
+		std::size_t i = position(value);
+		return i == npos ? end() : begin() + i;
+	}
+
+
+	/**
+		@brief Count the elements equal to a value
+
+		@param value the value to look for
+		@return the number of elements equal to value, either 0 or 1
+	*/
+	unsigned int count(const T& value) const
+	{
+		return contains(value) ? 1 : 0;
+	}
+
+
+	/**
+		@brief Swap the content of two sets
+
+		@param other the set whose elements are exchanged with the current set
+	*/
+	void swap(flat_set& other)
+	{
+		_values.swap(other._values);
+		_tags.swap(other._tags);
+		_slots.swap(other._slots);
+		std::swap(_slotBits, other._slotBits);
+	}
+
+
+	/**
+		@brief Get the const_iterator at the beginning of the data sequence
+
+		@return const_iterator at the beginning of the data sequence
+	*/
+	const_iterator begin() const
+	{
+		return _values.begin();
+	}
+
+
+	/**
+		@brief Get the const_iterator at the end of the data sequence
+
+		@return const_iterator at the end of the data sequence
+	*/
+	const_iterator end() const
+	{
+		return _values.end();
+	}
+
+};
+
+/**
+	@brief Stream operator <<
+
+	Overriding of operator<< to write the elements of a flat_set on a stream.
+
+	@tparam T the type of elements stored in the set setToPrint
+	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam Hash functor used to compute the hash of an element
+	@param os output stream on which an element is sent
+	@param setToPrint the set to be sent on the output stream
+	@return the reference of the output stream
+*/
+template<typename T, typename Eql, typename Hash>
+std::ostream &operator<<(std::ostream &os, const flat_set<T, Eql, Hash> &setToPrint)
+{
+	typename flat_set<T, Eql, Hash>::const_iterator ib, ie;
+	for (ib = setToPrint.begin(), ie = setToPrint.end(); ib!=ie; ++ib)
+	{
+		os << *ib << '\n';
+	}
+	return os;
+}
+
+
+/**
+	@brief Filter out the elements of a flat_set
+
+	This function creates and returns a new set, whose elements come from
+	a set in input that do NOT satisfy a certain predicate.
+
+	@tparam T the type of elements stored in the set s
+	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam Hash functor used to compute the hash of an element
+	@tparam Pred the predicate that musn't be satisfied
+	@param s the set whose elements will be analyzed and saved if they do NOT satisfy the predicate Pred
+	@return a new set containing the elements of s filtered out
+*/
+template<typename T, typename Eql, typename Hash, typename Pred>
+flat_set<T, Eql, Hash> filter_out(const flat_set<T, Eql, Hash> &s, Pred pred)
+{
+	return (s | filtered_out(pred)).materialize();
+}
+
+
+/**
+	@brief Create a new flat_set with the elements of two other sets
+
+	This function creates and returns a new set, whose elements come from
+	the union of two sets in input.
+
+	@tparam T the type of elements stored in the sets
+	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam Hash functor used to compute the hash of an element
+	@param s1 the first set
+	@param s2 the second set
+	@return a new set of elements of s1 and s2
+	@throw duplicated_element_exception if an element appears more than once in the sets
+*/
+template<typename T, typename Eql, typename Hash>
+flat_set<T, Eql, Hash> operator+(const flat_set<T, Eql, Hash> &s1, const flat_set<T, Eql, Hash> &s2)
+{
+	flat_set<T, Eql, Hash> resultSet(s1);
+	typename flat_set<T, Eql, Hash>::const_iterator ib, ie;
+	for (ib = s2.begin(), ie = s2.end(); ib != ie; ++ib)
+		resultSet.add(*ib);
+	return resultSet;
+}
+
+
+/**
+	@brief Create a new flat_set with the elements of two other sets, skipping duplicates
+
+	It is operator+ in insert_or_ignore mode.
+
+	@tparam T the type of elements stored in the sets
+	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam Hash functor used to compute the hash of an element
+	@param s1 the first set
+	@param s2 the second set
+	@return a new set of elements of s1 and s2, each one once
+*/
+template<typename T, typename Eql, typename Hash>
+flat_set<T, Eql, Hash> plus(const flat_set<T, Eql, Hash> &s1, const flat_set<T, Eql, Hash> &s2, insert_or_ignore_t)
+{
+	flat_set<T, Eql, Hash> resultSet(s1);
+	typename flat_set<T, Eql, Hash>::const_iterator ib, ie;
+	for (ib = s2.begin(), ie = s2.end(); ib != ie; ++ib)
+		resultSet.try_add(*ib);
+	return resultSet;
+}
+
+
+/**
+	@brief Create a new flat_set with the elements of a temporary set and another set
+
+	The storage of s1 is taken over by the new set, without copying it.
+
+	@tparam T the type of elements stored in the sets
+	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam Hash functor used to compute the hash of an element
+	@param s1 the first set, a temporary
+	@param s2 the second set
+	@return a new set of elements of s1 and s2
+	@throw duplicated_element_exception if an element appears more than once in the sets
+*/
+template<typename T, typename Eql, typename Hash>
+flat_set<T, Eql, Hash> operator+(flat_set<T, Eql, Hash> &&s1, const flat_set<T, Eql, Hash> &s2)
+{
+	flat_set<T, Eql, Hash> resultSet(std::move(s1));
+	typename flat_set<T, Eql, Hash>::const_iterator ib, ie;
+	for (ib = s2.begin(), ie = s2.end(); ib != ie; ++ib)
+		resultSet.add(*ib);
+	return resultSet;
+}
+
+#endif
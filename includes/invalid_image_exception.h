@@ -0,0 +1,38 @@
+#ifndef INVALID_IMAGE_EXCEPTION_H
+#define INVALID_IMAGE_EXCEPTION_H
+
+#include <stdexcept>
+#include <string>
+
+/**
+	@file invalid_image_exception.h
+	@brief Declaration of a custom exception
+**/
+
+/**
+	@brief Declaration of a custom exception
+
+	Custom exception which represents the event of a binary image of a set
+	that cannot be read, because it is truncated, damaged or of another type. 
+*/
+class invalid_image_exception : public std::runtime_error 
+{
+
+public:
+	/**	
+		@brief Default constructor
+		
+		Constructor without error messages in input.
+	*/
+	invalid_image_exception();
+
+	/**	@brief Secondary constructor
+
+		Constructor with an error message in input.
+
+		@param message an error message
+	*/
+	invalid_image_exception(const std::string &message);
+};
+
+#endif
@@ -0,0 +1,323 @@
+#ifndef MAPPED_SET_H
+#define MAPPED_SET_H
+
+#include <cstddef>     // std::size_t
+#include <cstdint>     // std::uint32_t, std::uint64_t
+#include <cstring>     // std::memcpy
+#include <fstream>     // std::ifstream
+#include <memory>      // std::unique_ptr
+#include <string>      // std::string
+#include <type_traits> // std::is_same, std::is_trivially_copyable
+#include "set.h"
+#include "simd_find.h"
+#include "serialization.h"
+#include "invalid_image_exception.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>     // open
+#include <sys/mman.h>  // mmap, munmap
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // close
+#define MAPPED_SET_MMAP 1
+#endif
+
+/**
+	@file mapped_set.h
+	@brief Declaration of mapped_set class
+**/
+
+/**
+	@brief A read-only set over a binary image in a file
+
+	The file written by serialize is mapped in memory and used as it is: the
+	elements are read in place, so opening a set of any size takes constant
+	time, and the pages are loaded by the system when they are first touched
+	and shared by all the processes mapping the same file.
+	If Hash is given, the image must have been written with an index built
+	by the same hash functor, and lookups take average O(1) time; otherwise
+	lookups scan the elements.
+	Only images of trivially copyable elements (fixed-size records) can be
+	mapped; the other ones can be read back with deserialize.
+	Where mmap is not available the file is read into memory at once.
+
+	@tparam T the type of the element stored.
+	@tparam Eql functor used to check whether two elements are equal or not.
+	@tparam Hash functor used to compute the hash of an element (no_hash for no index).
+*/
+template <typename T, typename Eql, typename Hash = no_hash<T> >
+class mapped_set
+{
+	static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable elements can be read in place");
+	static_assert(alignof(T) <= 16, "the records of an image are aligned to 16 bytes at most");
+
+	/// true if and only if lookups use the index of the image
+	static const bool hashed = !std::is_same<Hash, no_hash<T> >::value;
+
+	/// true if and only if the elements are scanned with simd_find
+	static const bool vectorized = !hashed && is_builtin_equality<Eql, T>::value && is_simd_comparable<T>::value;
+
+	const char* _image;            ///< The image, mapped or read
+	std::size_t _imageSize;        ///< The size in bytes of the image
+	const T* _values;              ///< The elements, inside the image
+	std::size_t _size;             ///< Number of elements
+	const std::uint32_t* _slots;   ///< The index, inside the image, or 0
+	std::size_t _slotCount;        ///< Number of slots of the index
+	unsigned int _slotBits;        ///< log2 of the number of slots
+	std::unique_ptr<std::max_align_t[]> _buffer; ///< The image, if it has been read instead of mapped
+
+	Eql _equal;                    ///< Functor used to check whether two elements are equal or not
+	Hash _hash;                    ///< Functor used to compute the hash of an element
+
+	mapped_set(const mapped_set &other); // not copyable
+	mapped_set& operator=(const mapped_set &other); // not assignable
+
+
+	/**
+		Helper function used to get the image of a file in memory.
+
+		@param path the name of the file
+		@throw invalid_image_exception if the file cannot be read
+	*/
+	void load(const std::string &path)
+	{
+#ifdef MAPPED_SET_MMAP
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw invalid_image_exception("cannot open " + path);
+		struct stat info;
+		if (::fstat(fd, &info) != 0)
+		{
+			::close(fd);
+			throw invalid_image_exception("cannot read " + path);
+		}
+		_imageSize = static_cast<std::size_t>(info.st_size);
+		void* image = _imageSize == 0 ? MAP_FAILED : ::mmap(0, _imageSize, PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd);
+		if (image == MAP_FAILED)
+			throw invalid_image_exception("cannot map " + path);
+		_image = static_cast<const char*>(image);
+#else
+		std::ifstream file(path.c_str(), std::ios::binary | std::ios::ate);
+		if (!file)
+			throw invalid_image_exception("cannot open " + path);
+		_imageSize = static_cast<std::size_t>(file.tellg());
+		_buffer.reset(new std::max_align_t[_imageSize / sizeof(std::max_align_t) + 1]);
+		file.seekg(0);
+		if (!file.read(reinterpret_cast<char*>(_buffer.get()), _imageSize))
+			throw invalid_image_exception("cannot read " + path);
+		_image = reinterpret_cast<const char*>(_buffer.get());
+#endif
+	}
+
+
+	/**
+		Helper function used to give the image back.
+	*/
+	void unload()
+	{
+#ifdef MAPPED_SET_MMAP
+		if (_image != 0)
+			::munmap(const_cast<char*>(_image), _imageSize);
+#endif
+		_buffer.reset();
+		_image = 0;
+	}
+
+
+	/**
+		Helper function used to check the header of the image and to find
+		the elements and the index in it.
+
+		@throw invalid_image_exception if the image cannot be used by this set
+	*/
+	void attach()
+	{
+		if (_imageSize < sizeof(set_image_header))
+			throw invalid_image_exception("not a set image");
+		set_image_header header;
+		std::memcpy(&header, _image, sizeof(header));
+		if (!header.valid())
+			throw invalid_image_exception("not a set image");
+		if (header.recordSize != sizeof(T))
+			throw invalid_image_exception("set image of another type");
+
+		std::size_t available = (_imageSize - sizeof(header)) / sizeof(T);
+		if (header.count > available)
+			throw invalid_image_exception("truncated set image");
+		_size = static_cast<std::size_t>(header.count);
+		_values = reinterpret_cast<const T*>(_image + sizeof(header));
+
+		if constexpr (hashed)
+		{
+			std::size_t end = sizeof(header) + _size * sizeof(T);
+			end += (4 - end % 4) % 4;
+			if (header.slotCount == 0)
+				throw invalid_image_exception("set image without index");
+			if ((header.slotCount & (header.slotCount - 1)) != 0 || header.slotCount <= _size
+				|| header.slotCount > (_imageSize - end) / sizeof(std::uint32_t))
+				throw invalid_image_exception("damaged set image index");
+			_slots = reinterpret_cast<const std::uint32_t*>(_image + end);
+			_slotCount = static_cast<std::size_t>(header.slotCount);
+			_slotBits = 0;
+			while ((std::size_t(1) << _slotBits) < _slotCount)
+				++_slotBits;
+		}
+	}
+
+
+	/**
+		Helper function used to find the position of a value.
+
+		@param value the value to look for
+		@return the position of value, or size() if it is not in the set
+	*/
+	std::size_t position(const T& value) const
+	{
+		if constexpr (hashed)
+		{
+			std::size_t mask = _slotCount - 1;
+			for (std::size_t i = image_home_slot(_hash(value), _slotBits), probes = 0;
+				_slots[i] != 0 && probes < _slotCount; i = (i + 1) & mask, ++probes)
+			{
+				std::size_t p = _slots[i] - 1;
+				if (p < _size && _equal(value, _values[p]))
+					return p;
+			}
+			return _size;
+		}
+		else if constexpr (vectorized)
+			return simd_find(_values, _size, value);
+		else
+		{
+			for (std::size_t i = 0; i < _size; ++i)
+				if (_equal(value, _values[i]))
+					return i;
+			return _size;
+		}
+	}
+
+public:
+
+	/// The iterator of the set, a pointer to its elements
+	typedef const T* const_iterator;
+
+	/**
+		@brief Constructor
+
+		It maps the image of a set written by serialize: if the set is hashed,
+		the image must have been written with an index by the same hash functor.
+
+		@param path the name of the file of the image
+		@throw invalid_image_exception if the file cannot be read or it is not a suitable image
+	*/
+	explicit mapped_set(const std::string &path)
+		: _image(0), _imageSize(0), _values(0), _size(0), _slots(0), _slotCount(0), _slotBits(0)
+	{
+		load(path);
+		try
+		{
+			attach();
+		}
+		catch (...)
+		{
+			unload();
+			throw;
+		}
+	}
+
+
+	/**
+		@brief Destructor
+
+		It unmaps the image.
+	*/
+	~mapped_set()
+	{
+		unload();
+	}
+
+
+	/**
+		@brief Get the element at a position
+
+		@param i the position of the element
+		@return the element at position i
+	*/
+	const T& operator[](unsigned int i) const
+	{
+		assert(i < _size);
+		return _values[i];
+	}
+
+
+	/**
+		@brief Get the number of elements in the set
+
+		@return the size of the set
+	*/
+	unsigned int size() const
+	{
+		return static_cast<unsigned int>(_size);
+	}
+
+
+	/**
+		@brief Check whether a value is in the set
+
+		@param value the value to look for
+		@return true if and only if an element equal to value is in the set
+	*/
+	bool contains(const T& value) const
+	{
+		return position(value) != _size;
+	}
+
+
+	/**
+		@brief Find a value in the set
+
+		@param value the value to look for
+		@return const_iterator to the element, or end() if there is none
+	*/
+	const_iterator find(const T& value) const
+	{
+		return _values + position(value);
+	}
+
+
+	/**
+		@brief Count the elements equal to a value
+
+		@param value the value to look for
+		@return the number of elements equal to value, either 0 or 1
+	*/
+	unsigned int count(const T& value) const
+	{
+		return contains(value) ? 1 : 0;
+	}
+
+
+	/**
+		@brief Get the const_iterator at the beginning of the data sequence
+
+		@return const_iterator at the beginning of the data sequence
+	*/
+	const_iterator begin() const
+	{
+		return _values;
+	}
+
+
+	/**
+		@brief Get the const_iterator at the end of the data sequence
+
+		@return const_iterator at the end of the data sequence
+	*/
+	const_iterator end() const
+	{
+		return _values + _size;
+	}
+
+};
+
+#endif
@@ -0,0 +1,303 @@
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+#include <cstddef>     // std::size_t, std::max_align_t
+#include <memory>      // std::shared_ptr
+#include <new>         // ::operator new
+#include <type_traits> // std::true_type, std::false_type, std::is_pointer
+#include <utility>     // std::declval
+
+/**
+	@file node_pool.h
+	@brief Declaration of node_pool class and node_pool_allocator class
+**/
+
+/**
+	@brief A pool of fixed-size nodes
+
+	Memory is taken from the heap in slabs, each one holding many nodes.
+	Nodes are given out from the current slab and, once freed, they are kept
+	in a free list and reused by the following allocations.
+	The size of the nodes is fixed by the first allocation: requests of a
+	different size are refused, so that the caller can serve them elsewhere.
+	All the slabs are given back to the heap when the pool is released or
+	destroyed, no matter how many nodes are still in use.
+	The pool also counts the blocks its users had to take from the heap
+	instead, so that they know when a release would not free everything.
+*/
+class node_pool
+{
+
+	/** @brief A free node, linked to the other free nodes */
+	struct free_node
+	{
+		free_node* next; ///< the next free node
+	};
+
+	/** @brief Header of a slab, linked to the other slabs */
+	struct slab
+	{
+		slab* next;         ///< the previously allocated slab
+		std::size_t nodes;  ///< number of nodes in the slab
+	};
+
+	std::size_t _nodeSize;     ///< Requested size of a node, 0 before the first allocation
+	std::size_t _stride;       ///< Distance in bytes between two nodes of a slab
+	std::size_t _nextSlab;     ///< Number of nodes of the next slab
+	slab* _slabs;              ///< The last allocated slab
+	free_node* _free;          ///< The first free node
+	char* _cursor;             ///< The first never used node of the last slab
+	char* _limit;              ///< The end of the last slab
+	std::size_t _inUse;        ///< Number of nodes given out and not freed yet
+	std::size_t _reserved;     ///< Number of nodes in all the slabs
+	std::size_t _outside;      ///< Number of blocks taken from the heap instead of the pool and not freed yet
+
+	/**
+		Helper function used to take a new slab from the heap.
+	*/
+	void grow();
+
+	node_pool(const node_pool &other); // not copyable
+	node_pool& operator=(const node_pool &other); // not assignable
+
+public:
+
+	/**
+		@brief Default constructor
+
+		It creates an empty pool, with no slabs.
+	*/
+	node_pool();
+
+	/**
+		@brief Destructor
+
+		It gives all the slabs back to the heap.
+	*/
+	~node_pool();
+
+	/**
+		@brief Get a node from the pool
+
+		@param size the size of the node
+		@return a pointer to the node, or 0 if size is not the size of the nodes of the pool
+		@throw std::bad_alloc
+	*/
+	void* allocate(std::size_t size);
+
+	/**
+		@brief Give a node back to the pool
+
+		@param p a pointer to a node
+		@param size the size of the node
+		@return false if size is not the size of the nodes of the pool, so p was not taken
+	*/
+	bool deallocate(void* p, std::size_t size);
+
+	/**
+		@brief Give all the slabs back to the heap
+
+		Every node of the pool is freed at once, without visiting them:
+		it takes a time proportional to the number of slabs.
+	*/
+	void release();
+
+	/**
+		@brief Take a block from the heap, outside the slabs
+
+		It is used for the requests the pool can't serve: the block is
+		counted until it is given back with deallocate_outside.
+
+		@param size the size of the block
+		@return a pointer to the block
+		@throw std::bad_alloc
+	*/
+	void* allocate_outside(std::size_t size);
+
+	/**
+		@brief Give back to the heap a block taken with allocate_outside
+
+		@param p a pointer to the block
+	*/
+	void deallocate_outside(void* p);
+
+	/** @brief Size in bytes of the nodes, 0 if nothing has been allocated yet */
+	std::size_t node_size() const;
+
+	/** @brief Number of nodes given out and not freed yet */
+	std::size_t nodes_in_use() const;
+
+	/** @brief Number of blocks taken with allocate_outside and not freed yet */
+	std::size_t blocks_outside() const;
+
+	/** @brief Number of nodes held by all the slabs */
+	std::size_t nodes_reserved() const;
+
+	/** @brief Number of bytes taken from the heap */
+	std::size_t bytes_reserved() const;
+};
+
+
+/**
+	@brief A standard allocator that takes single nodes from a node_pool
+
+	Allocations of exactly one object are served by a node_pool shared by all
+	the copies of the allocator, also when rebound to other types; any other
+	request goes to the global operator new.
+	Pointers are never taken from the pool: a container allocates them
+	only as arrays of buckets, and a one-bucket array must not fix the
+	size of the pool before the first node does.
+	A container copy gets a new pool, while moves and swaps carry the pool
+	along with the nodes.
+
+	@tparam T the type of the objects allocated
+*/
+template <typename T>
+class node_pool_allocator
+{
+
+	template <typename U> friend class node_pool_allocator;
+
+	std::shared_ptr<node_pool> _pool; ///< The pool shared by the copies of the allocator
+
+	/// true if and only if a single T can be taken from the pool
+	static const bool pooled = alignof(T) <= alignof(std::max_align_t) && !std::is_pointer<T>::value;
+
+public:
+	typedef T                 value_type;
+	typedef std::false_type   propagate_on_container_copy_assignment;
+	typedef std::true_type    propagate_on_container_move_assignment;
+	typedef std::true_type    propagate_on_container_swap;
+	typedef std::false_type   is_always_equal;
+
+	/** @brief Default constructor, it creates a new pool */
+	node_pool_allocator() : _pool(std::make_shared<node_pool>())
+	{}
+
+	/** @brief Copy constructor, it shares the pool of other */
+	node_pool_allocator(const node_pool_allocator &other) noexcept : _pool(other._pool)
+	{}
+
+	/** @brief Assignment operator, it shares the pool of other */
+	node_pool_allocator& operator=(const node_pool_allocator &other) noexcept
+	{
+		_pool = other._pool;
+		return *this;
+	}
+
+	/** @brief Converting constructor, it shares the pool of other */
+	template <typename U>
+	node_pool_allocator(const node_pool_allocator<U> &other) noexcept : _pool(other._pool)
+	{}
+
+	/**
+		@brief Allocate storage for n objects
+
+		@param n number of objects
+		@return a pointer to the storage
+		@throw std::bad_alloc
+	*/
+	T* allocate(std::size_t n)
+	{
+		if (pooled && n == 1)
+		{
+			void* p = _pool->allocate(sizeof(T));
+			if (p != 0)
+				return static_cast<T*>(p);
+		}
+		return static_cast<T*>(_pool->allocate_outside(n * sizeof(T)));
+	}
+
+	/**
+		@brief Deallocate storage obtained from allocate
+
+		@param p pointer to the storage
+		@param n number of objects
+	*/
+	void deallocate(T* p, std::size_t n)
+	{
+		if (pooled && n == 1 && _pool->deallocate(p, sizeof(T)))
+			return;
+		_pool->deallocate_outside(p);
+	}
+
+	/** @brief A container copy gets an allocator with a new pool */
+	node_pool_allocator select_on_container_copy_construction() const
+	{
+		return node_pool_allocator();
+	}
+
+	/**
+		@brief Free every node of the pool at once
+
+		It succeeds only if no other allocator shares the pool,
+		so that no one else can still be using its nodes, and if every
+		block taken outside the pool has been freed, since a release
+		would leak them.
+
+		@return true if the pool has been released
+	*/
+	bool release()
+	{
+		if (_pool.use_count() != 1 || _pool->blocks_outside() != 0)
+			return false;
+		_pool->release();
+		return true;
+	}
+
+	/** @brief Get the pool used by the allocator */
+	const node_pool& pool() const
+	{
+		return *_pool;
+	}
+
+	/** @brief Equality, two allocators are equal if they share the pool */
+	template <typename U>
+	bool operator==(const node_pool_allocator<U> &other) const
+	{
+		return _pool == other._pool;
+	}
+
+	/** @brief Inequality */
+	template <typename U>
+	bool operator!=(const node_pool_allocator<U> &other) const
+	{
+		return _pool != other._pool;
+	}
+};
+
+
+/**
+	@brief Check whether an allocator can free all its storage at once
+
+	It is true for allocators with a bool release() member function,
+	like node_pool_allocator.
+
+	@tparam A the type of the allocator
+*/
+template <typename A, typename = void>
+struct has_bulk_release : std::false_type
+{};
+
+template <typename A>
+struct has_bulk_release<A, decltype(void(static_cast<bool>(std::declval<A&>().release())))> : std::true_type
+{};
+
+
+/**
+	@brief Check whether an allocator takes its storage from a node_pool
+
+	It is true for allocators with a pool() member function returning
+	the node_pool, like node_pool_allocator.
+
+	@tparam A the type of the allocator
+*/
+template <typename A, typename = void>
+struct has_node_pool : std::false_type
+{};
+
+template <typename A>
+struct has_node_pool<A, decltype(void(static_cast<const node_pool&>(std::declval<const A&>().pool())))> : std::true_type
+{};
+
+#endif
@@ -0,0 +1,685 @@
+#ifndef ORDERED_SET_H
+#define ORDERED_SET_H
+
+#include <algorithm>   // std::lower_bound, std::upper_bound, std::sort
+#include <cassert>     // assert()
+#include <functional>  // std::less
+#include <ostream>     // std::ostream
+#include <utility>     // std::move, std::forward
+#include <vector>      // std::vector
+#include "set.h"
+#include "non_existent_element_exception.h"
+#include "duplicated_element_exception.h"
+
+/**
+	@file ordered_set.h
+	@brief Declaration of ordered_set class
+**/
+
+/**
+	@brief A dynamic set of elements kept in order.
+
+	It has the same interface of set, but the elements are kept sorted by a
+	comparison functor (of type Less) in a single array: iteration and
+	operator[] follow the order, lookups take O(log n) time and ranges of
+	values can be found with lower_bound and upper_bound.
+	Two elements are equal if neither of them is less than the other.
+	Adding or removing an element shifts the elements after it, so it takes
+	O(n) time; a whole sequence is better added through the constructor.
+
+	@tparam T the type of the element stored.
+	@tparam Less functor used to check whether an element comes before another one.
+*/
+template <typename T, typename Less = std::less<T> >
+class ordered_set
+{
+
+	std::vector<T> _values;     ///< The elements, sorted
+	Less _less;                 ///< Functor used to compare two elements
+
+
+	/**
+		Helper function used to check whether a value is equal to an element.
+
+		@param value a value
+		@param it an iterator to an element, or end
+		@return true if and only if it points to an element equal to value
+	*/
+	bool isAt(const T& value, typename std::vector<T>::const_iterator it) const
+	{
+		return it != _values.end() && !_less(value, *it);
+	}
+
+
+	/**
+		Helper function used to add an element to the set at its position.
+
+		@tparam V the type of the value, a reference to T
+		@param newValue the value of the new element to be inserted, copied or moved
+		@return true if the element has been added, false if it was a duplicate
+	*/
+	template <typename V>
+	bool insert(V&& newValue)
+	{
+		typename std::vector<T>::const_iterator it = lower_bound(newValue);
+		if (isAt(newValue, it))
+			return false;
+		_values.insert(it, std::forward<V>(newValue));
+		return true;
+	}
+
+public:
+
+	/**
+		@brief Random access const_iterator of the class
+
+		It is used to iterate over the elements of the set, in order.
+	*/
+	typedef typename std::vector<T>::const_iterator const_iterator;
+
+
+	/**
+		@brief Default constructor
+
+		It is used to create a new empty set.
+	*/
+	ordered_set()
+	{}
+
+
+	/**
+		@brief Constructor with a comparison functor
+
+		It is used to create a new empty set whose elements are compared
+		by less, for comparison functors that hold a state.
+
+		@param less the comparison functor
+	*/
+	explicit ordered_set(const Less &less) : _less(less)
+	{}
+
+
+	/**
+		@brief Secondary constructor
+
+		It creates a set using a data sequence defined by a generic
+		pair of iterators. The values are sorted all together, so it takes
+		O(n log n) time.
+
+		@tparam Q the type of the iterator
+		@param b begin iterator
+		@param e end iterator
+		@param less the comparison functor
+		@throw duplicated_element_exception
+		@throw std::exception
+	*/
+	template <typename Q>
+	ordered_set(Q b, Q e, const Less &less = Less()) : _less(less)
+	{
+		_values.reserve(range_size_hint(b, e));
+		while (b != e)
+		{
+			_values.push_back(static_cast<T>(*b));
+			++b;
+		}
+		std::sort(_values.begin(), _values.end(), _less);
+		for (std::size_t i = 1; i < _values.size(); ++i)
+			if (!_less(_values[i - 1], _values[i]))
+				throw duplicated_element_exception();
+	}
+
+
+	/**
+		@brief Secondary constructor, skipping duplicates
+
+		It creates a set using a data sequence defined by a generic
+		pair of iterators. Only the first occurrence of each value is kept.
+
+		@tparam Q the type of the iterator
+		@param b begin iterator
+		@param e end iterator
+		@param less the comparison functor
+		@throw std::exception
+	*/
+	template <typename Q>
+	ordered_set(Q b, Q e, insert_or_ignore_t, const Less &less = Less()) : _less(less)
+	{
+		_values.reserve(range_size_hint(b, e));
+		while (b != e)
+		{
+			_values.push_back(static_cast<T>(*b));
+			++b;
+		}
+		std::stable_sort(_values.begin(), _values.end(), _less);
+		_values.erase(std::unique(_values.begin(), _values.end(),
+			[this](const T& a, const T& b) { return !_less(a, b); }), _values.end());
+	}
+
+
+	/**
+		@brief Adopt an array that is already sorted and without duplicates
+
+		@pre the values are sorted by less and have no duplicates
+		@param values the values of the new set
+		@param less the comparison functor of the new set
+		@return a new set with the values
+	*/
+	static ordered_set from_sorted(std::vector<T>&& values, const Less &less = Less())
+	{
+		ordered_set result(less);
+		result._values = std::move(values);
+		return result;
+	}
+
+
+	/**
+		@brief Secondary constructor, trusting the range to have no duplicates
+
+		It creates a set using a data sequence defined by a generic
+		pair of iterators, such as a filter_view of another set, whose
+		elements are known to be unique. The values are sorted only if 
+		they are not in order already.
+
+		@tparam Q the type of the iterator
+		@param b begin iterator
+		@param e end iterator
+		@param less the comparison functor
+		@throw std::exception
+	*/
+	template <typename Q>
+	ordered_set(Q b, Q e, assume_unique_t, const Less &less = Less()) : _less(less)
+	{
+		_values.reserve(range_size_hint(b, e));
+		while (b != e)
+		{
+			_values.push_back(static_cast<T>(*b));
+			++b;
+		}
+		if (!std::is_sorted(_values.begin(), _values.end(), _less))
+			std::sort(_values.begin(), _values.end(), _less);
+	}
+
+
+	/**
+		@brief Prepare the set for a number of elements
+
+		@param count the number of elements expected in the set
+	*/
+	void reserve(std::size_t count)
+	{
+		_values.reserve(count);
+	}
+
+
+	/**
+		@brief Add an element to the set
+
+		It adds a new element to the set at the position given by its value.
+
+		@param val value of the new element
+		@throw duplicated_element_exception
+	*/
+	void add(const T& val)
+	{
+		if (!insert(val))
+			throw duplicated_element_exception();
+	}
+
+
+	/**
+		@brief Add an element to the set, moving its value
+
+		@param val value of the new element
+		@throw duplicated_element_exception
+	*/
+	void add(T&& val)
+	{
+		if (!insert(std::move(val)))
+			throw duplicated_element_exception();
+	}
+
+
+	/**
+		@brief Add an element to the set, if it is not there yet
+
+		@param val value of the new element
+		@return true if the element has been added, false if it was already in the set
+	*/
+	bool try_add(const T& val)
+	{
+		return insert(val);
+	}
+
+
+	/**
+		@brief Add an element to the set moving its value, if it is not there yet
+
+		@param val value of the new element
+		@return true if the element has been added, false if it was already in the set
+	*/
+	bool try_add(T&& val)
+	{
+		return insert(std::move(val));
+	}
+
+
+	/**
+		@brief Build an element and add it to the set
+
+		@tparam Args the types of the arguments
+		@param args the arguments passed to a constructor of T
+		@throw duplicated_element_exception
+	*/
+	template <typename... Args>
+	void emplace(Args&&... args)
+	{
+		if (!insert(T(std::forward<Args>(args)...)))
+			throw duplicated_element_exception();
+	}
+
+
+	/**
+		@brief Delete an element from the set
+
+		@param toDelete value of the element that has to be deleted
+		@throw non_existent_element_exception
+	*/
+	void remove(const T& toDelete)
+	{
+		if (!try_remove(toDelete))
+			throw non_existent_element_exception();
+	}
+
+
+	/**
+		@brief Delete an element from the set, if it is there
+
+		@param toDelete value of the element that has to be deleted
+		@return true if the element has been removed, false if it was not in the set
+	*/
+	bool try_remove(const T& toDelete)
+	{
+		const_iterator it = lower_bound(toDelete);
+		if (!isAt(toDelete, it))
+			return false;
+		_values.erase(it);
+		return true;
+	}
+
+
+	/**
+		@brief Get an element from the set
+
+		It gets the i-th smallest element of the set in constant time.
+
+		@pre it is necessary that i < size
+		@param i index of the element in the set
+		@return the value of the element in i-th position
+	*/
+	const T& operator[](unsigned int i) const
+	{
+		assert(i < _values.size());
+		return _values[i];
+	}
+
+
+	/**
+		@brief Get the number of elements in the set
+
+		@return the size of the set
+	*/
+	unsigned int size() const
+	{
+		return static_cast<unsigned int>(_values.size());
+	}
+
+
+	/**
+		@brief Check whether a value is in the set
+
+		@param value the value to look for
+		@return true if and only if an element equal to value is in the set
+	*/
+	bool contains(const T& value) const
+	{
+		return isAt(value, lower_bound(value));
+	}
+
+
+	/**
+		@brief Find a value in the set
+
+		@param value the value to look for
+		@return const_iterator to the element, or end() if there is none
+	*/
+	const_iterator find(const T& value) const
+	{
+		const_iterator it = lower_bound(value);
+		return isAt(value, it) ? it : end();
+	}
+
+
+	/**
+		@brief Count the elements equal to a value
+
+		@param value the value to look for
+		@return the number of elements equal to value, either 0 or 1
+	*/
+	unsigned int count(const T& value) const
+	{
+		return contains(value) ? 1 : 0;
+	}
+
+
+	/**
+		@brief Get the comparison functor of the set
+
+		@return a copy of the functor used to order the elements
+	*/
+	Less key_comp() const
+	{
+		return _less;
+	}
+
+
+	/**
+		@brief Get the first element not less than a value
+
+		@param value the value
+		@return const_iterator to the first element not less than value, or end()
+	*/
+	const_iterator lower_bound(const T& value) const
+	{
+		return std::lower_bound(_values.begin(), _values.end(), value, _less);
+	}
+
+
+	/**
+		@brief Get the first element greater than a value
+
+		@param value the value
+		@return const_iterator to the first element greater than value, or end()
+	*/
+	const_iterator upper_bound(const T& value) const
+	{
+		return std::upper_bound(_values.begin(), _values.end(), value, _less);
+	}
+
+
+	/**
+		@brief Swap the content of two sets
+
+		@param other the set whose elements are exchanged with the current set
+	*/
+	void swap(ordered_set& other)
+	{
+		_values.swap(other._values);
+		std::swap(_less, other._less);
+	}
+
+
+	/**
+		@brief Get the const_iterator at the smallest element
+
+		@return const_iterator at the beginning of the data sequence
+	*/
+	const_iterator begin() const
+	{
+		return _values.begin();
+	}
+
+
+	/**
+		@brief Get the const_iterator past the greatest element
+
+		@return const_iterator at the end of the data sequence
+	*/
+	const_iterator end() const
+	{
+		return _values.end();
+	}
+
+};
+
+/**
+	@brief Stream operator <<
+
+	Overriding of operator<< to write the elements of an ordered_set on a stream, in order.
+
+	@tparam T the type of elements stored in the set setToPrint
+	@tparam Less functor used to compare two elements
+	@param os output stream on which an element is sent
+	@param setToPrint the set to be sent on the output stream
+	@return the reference of the output stream
+*/
+template<typename T, typename Less>
+std::ostream &operator<<(std::ostream &os, const ordered_set<T, Less> &setToPrint)
+{
+	typename ordered_set<T, Less>::const_iterator ib, ie;
+	for (ib = setToPrint.begin(), ie = setToPrint.end(); ib!=ie; ++ib)
+	{
+		os << *ib << '\n';
+	}
+	return os;
+}
+
+
+/**
+	@brief Filter out the elements of an ordered_set
+
+	The elements that do NOT satisfy the predicate are already in order
+	and unique, so they are appended to the new set without any check.
+
+	@tparam T the type of elements stored in the set s
+	@tparam Less functor used to compare two elements
+	@tparam Pred the predicate that musn't be satisfied
+	@param s the set whose elements will be analyzed and saved if they do NOT satisfy the predicate Pred
+	@return a new set containing the elements of s filtered out
+*/
+template<typename T, typename Less, typename Pred>
+ordered_set<T, Less> filter_out(const ordered_set<T, Less> &s, Pred pred)
+{
+	std::vector<T> values;
+	typename ordered_set<T, Less>::const_iterator ib, ie;
+	for (ib = s.begin(), ie = s.end(); ib != ie; ++ib)
+	{
+		if (!pred(*ib))
+			values.push_back(*ib);
+	}
+	return ordered_set<T, Less>::from_sorted(std::move(values), s.key_comp());
+}
+
+
+/**
+	@brief Merge two ordered sets
+
+	This function walks both sets once, in order, and keeps the values
+	chosen by a policy. It is used to implement the set algebra in O(n+m) time.
+	The sets are compared, and the result is ordered, by the comparison
+	functor of s1, which must order s2 the same way.
+
+	@tparam T the type of elements stored in the sets
+	@tparam Less functor used to compare two elements
+	@param s1 the first set
+	@param s2 the second set
+	@param onlyFirst whether to keep the values found only in s1
+	@param both whether to keep the values found in both sets
+	@param onlySecond whether to keep the values found only in s2
+	@param duplicatesThrow whether a value found in both sets raises an exception
+	@return a new set with the values kept
+	@throw duplicated_element_exception if duplicatesThrow and a value is in both sets
+*/
+template<typename T, typename Less>
+ordered_set<T, Less> merge_ordered(const ordered_set<T, Less> &s1, const ordered_set<T, Less> &s2,
+	bool onlyFirst, bool both, bool onlySecond, bool duplicatesThrow = false)
+{
+	Less less = s1.key_comp();
+	std::vector<T> values;
+	values.reserve((onlyFirst || both ? s1.size() : 0) + (onlySecond ? s2.size() : 0));
+	typename ordered_set<T, Less>::const_iterator i1 = s1.begin(), e1 = s1.end();
+	typename ordered_set<T, Less>::const_iterator i2 = s2.begin(), e2 = s2.end();
+	while (i1 != e1 && i2 != e2)
+	{
+		if (less(*i1, *i2))
+		{
+			if (onlyFirst)
+				values.push_back(*i1);
+			++i1;
+		}
+		else if (less(*i2, *i1))
+		{
+			if (onlySecond)
+				values.push_back(*i2);
+			++i2;
+		}
+		else
+		{
+			if (duplicatesThrow)
+				throw duplicated_element_exception();
+			if (both)
+				values.push_back(*i1);
+			++i1;
+			++i2;
+		}
+	}
+	if (onlyFirst)
+		values.insert(values.end(), i1, e1);
+	if (onlySecond)
+		values.insert(values.end(), i2, e2);
+	return ordered_set<T, Less>::from_sorted(std::move(values), less);
+}
+
+
+/**
+	@brief Union of two ordered sets, in O(n+m) time
+
+	@tparam T the type of elements stored in the sets
+	@tparam Less functor used to compare two elements
+	@param s1 the first set
+	@param s2 the second set
+	@return a new set with the elements of s1 or s2, each one once
+*/
+template<typename T, typename Less>
+ordered_set<T, Less> set_union(const ordered_set<T, Less> &s1, const ordered_set<T, Less> &s2)
+{
+	return merge_ordered(s1, s2, true, true, true);
+}
+
+
+/**
+	@brief Intersection of two ordered sets, in O(n+m) time
+
+	@tparam T the type of elements stored in the sets
+	@tparam Less functor used to compare two elements
+	@param s1 the first set
+	@param s2 the second set
+	@return a new set with the elements of both s1 and s2
+*/
+template<typename T, typename Less>
+ordered_set<T, Less> set_intersection(const ordered_set<T, Less> &s1, const ordered_set<T, Less> &s2)
+{
+	return merge_ordered(s1, s2, false, true, false);
+}
+
+
+/**
+	@brief Difference of two ordered sets, in O(n+m) time
+
+	@tparam T the type of elements stored in the sets
+	@tparam Less functor used to compare two elements
+	@param s1 the first set
+	@param s2 the second set
+	@return a new set with the elements of s1 that are not in s2
+*/
+template<typename T, typename Less>
+ordered_set<T, Less> set_difference(const ordered_set<T, Less> &s1, const ordered_set<T, Less> &s2)
+{
+	return merge_ordered(s1, s2, true, false, false);
+}
+
+
+/**
+	@brief Symmetric difference of two ordered sets, in O(n+m) time
+
+	@tparam T the type of elements stored in the sets
+	@tparam Less functor used to compare two elements
+	@param s1 the first set
+	@param s2 the second set
+	@return a new set with the elements that are in just one of s1 and s2
+*/
+template<typename T, typename Less>
+ordered_set<T, Less> symmetric_difference(const ordered_set<T, Less> &s1, const ordered_set<T, Less> &s2)
+{
+	return merge_ordered(s1, s2, true, false, true);
+}
+
+
+/** @brief Union of two ordered sets, see set_union */
+template<typename T, typename Less>
+ordered_set<T, Less> operator|(const ordered_set<T, Less> &s1, const ordered_set<T, Less> &s2)
+{
+	return set_union(s1, s2);
+}
+
+
+/** @brief Intersection of two ordered sets, see set_intersection */
+template<typename T, typename Less>
+ordered_set<T, Less> operator&(const ordered_set<T, Less> &s1, const ordered_set<T, Less> &s2)
+{
+	return set_intersection(s1, s2);
+}
+
+
+/** @brief Difference of two ordered sets, see set_difference */
+template<typename T, typename Less>
+ordered_set<T, Less> operator-(const ordered_set<T, Less> &s1, const ordered_set<T, Less> &s2)
+{
+	return set_difference(s1, s2);
+}
+
+
+/** @brief Symmetric difference of two ordered sets, see symmetric_difference */
+template<typename T, typename Less>
+ordered_set<T, Less> operator^(const ordered_set<T, Less> &s1, const ordered_set<T, Less> &s2)
+{
+	return symmetric_difference(s1, s2);
+}
+
+
+/**
+	@brief Create a new ordered_set with the elements of two other sets, skipping duplicates
+
+	It is operator+ in insert_or_ignore mode, that is the union of the sets.
+
+	@tparam T the type of elements stored in the sets
+	@tparam Less functor used to compare two elements
+	@param s1 the first set
+	@param s2 the second set
+	@return a new set of elements of s1 and s2, each one once
+*/
+template<typename T, typename Less>
+ordered_set<T, Less> plus(const ordered_set<T, Less> &s1, const ordered_set<T, Less> &s2, insert_or_ignore_t)
+{
+	return merge_ordered(s1, s2, true, true, true);
+}
+
+
+/**
+	@brief Create a new ordered_set with the elements of two other sets
+
+	It merges the two sets in O(n+m) time.
+
+	@tparam T the type of elements stored in the sets
+	@tparam Less functor used to compare two elements
+	@param s1 the first set
+	@param s2 the second set
+	@return a new set of elements of s1 and s2
+	@throw duplicated_element_exception if an element appears more than once in the sets
+*/
+template<typename T, typename Less>
+ordered_set<T, Less> operator+(const ordered_set<T, Less> &s1, const ordered_set<T, Less> &s2)
+{
+	return merge_ordered(s1, s2, true, true, true, true);
+}
+
+#endif
@@ -0,0 +1,217 @@
+#ifndef PARALLEL_FILTER_H
+#define PARALLEL_FILTER_H
+
+#include <cstddef>   // std::size_t, std::ptrdiff_t
+#include <exception> // std::exception_ptr, std::current_exception, std::rethrow_exception
+#include <iterator>  // std::forward_iterator_tag, std::iterator_traits
+#include <thread>    // std::thread
+#include <vector>    // std::vector
+#include "filter_view.h"
+
+/**
+	@file parallel_filter.h
+	@brief Declaration of the parallel execution policy and of the parallel overload of filter_out
+**/
+
+/**
+	@brief Execution policy of the parallel algorithms
+
+	It tells how many threads may run the predicates.
+*/
+struct parallel_policy
+{
+	unsigned int threads; ///< number of threads, 0 for one per core
+
+	/** @brief The number of threads to use, at least 1 */
+	unsigned int thread_count() const
+	{
+		if (threads != 0)
+			return threads;
+		unsigned int cores = std::thread::hardware_concurrency();
+		return cores == 0 ? 1 : cores;
+	}
+};
+
+
+/**
+	@brief Build a parallel execution policy
+
+	@param threads number of threads, by default one per core
+	@return the policy
+*/
+inline parallel_policy parallel(unsigned int threads = 0)
+{
+	parallel_policy policy = { threads };
+	return policy;
+}
+
+
+/**
+	@brief Run a job on many threads
+
+	work(t) is called once for each t in [0, threads): the calls but the
+	first run on new threads, the first one on the calling thread. 
+	If some calls throw, the exception of the lowest t is thrown again
+	once every thread has finished.
+
+	@tparam Work the type of the job, callable with a std::size_t
+	@param threads the number of calls, at least 1
+	@param work the job
+	@throw std::exception
+*/
+template <typename Work>
+void run_parallel(std::size_t threads, Work work)
+{
+	std::vector<std::exception_ptr> errors(threads);
+	auto guarded = [&work, &errors](std::size_t t)
+	{
+		try
+		{
+			work(t);
+		}
+		catch (...)
+		{
+			errors[t] = std::current_exception();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	workers.reserve(threads - 1);
+	try
+	{
+		for (std::size_t t = 1; t < threads; ++t)
+			workers.push_back(std::thread(guarded, t));
+	}
+	catch (...)
+	{
+		for (std::size_t i = 0; i < workers.size(); ++i)
+			workers[i].join();
+		throw;
+	}
+	guarded(0);
+	for (std::size_t i = 0; i < workers.size(); ++i)
+		workers[i].join();
+	for (std::size_t t = 0; t < threads; ++t)
+		if (errors[t])
+			std::rethrow_exception(errors[t]);
+}
+
+
+/**
+	@brief Forward iterator on the values pointed by a sequence of pointers
+
+	@tparam T the type of the values
+*/
+template <typename T>
+class indirect_iterator
+{
+
+	const T* const* _current; ///< The current pointer
+
+public:
+	typedef std::forward_iterator_tag iterator_category;
+	typedef T value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef const T* pointer;
+	typedef const T& reference;
+
+	explicit indirect_iterator(const T* const* current = 0) : _current(current)
+	{}
+
+	reference operator*() const
+	{
+		return **_current;
+	}
+
+	pointer operator->() const
+	{
+		return *_current;
+	}
+
+	indirect_iterator& operator++()
+	{
+		++_current;
+		return *this;
+	}
+
+	indirect_iterator operator++(int)
+	{
+		indirect_iterator tmp(*this);
+		++_current;
+		return tmp;
+	}
+
+	bool operator==(const indirect_iterator &other) const
+	{
+		return _current == other._current;
+	}
+
+	bool operator!=(const indirect_iterator &other) const
+	{
+		return _current != other._current;
+	}
+};
+
+
+/**
+	@brief Filter out the elements of a set, running the predicate on many threads
+
+	The set is split in as many chunks as threads, each chunk is checked by its
+	own thread and the survivors are copied into the new set in their original
+	order, without looking for duplicates.
+	It pays off when the predicate is expensive: the elements are walked once
+	more to split the set, and the threads are started at each call.
+	The predicate is called concurrently, so it must be safe to do it. If it
+	throws, the first exception, in the order of the chunks, is thrown again
+	once every thread has finished.
+
+	@tparam Source the type of the set, a set, a flat_set or an ordered_set
+	@tparam Pred the predicate that musn't be satisfied
+	@param s the set whose elements will be analyzed and saved if they do NOT satisfy the predicate Pred
+	@param pred the predicate, copied by each thread
+	@param policy the number of threads to use
+	@return a new set containing the elements of s filtered out
+	@throw std::exception
+*/
+template <typename Source, typename Pred>
+Source filter_out(const Source &s, Pred pred, parallel_policy policy)
+{
+	typedef typename std::iterator_traits<typename Source::const_iterator>::value_type T;
+
+	std::vector<const T*> values;
+	values.reserve(s.size());
+	for (typename Source::const_iterator ib = s.begin(), ie = s.end(); ib != ie; ++ib)
+		values.push_back(&*ib);
+
+	std::size_t threads = policy.thread_count();
+	if (threads > values.size())
+		threads = values.size();
+	if (threads <= 1)
+		return (s | filtered_out(pred)).materialize();
+
+	// each chunk keeps its survivors at the front of its own part of values
+	std::size_t chunk = (values.size() + threads - 1) / threads;
+	std::vector<std::size_t> kept(threads, 0);
+	run_parallel(threads, [&values, &kept, chunk, pred](std::size_t t)
+	{
+		std::size_t b = t * chunk;
+		std::size_t e = b + chunk < values.size() ? b + chunk : values.size();
+		std::size_t last = b;
+		Pred own(pred);
+		for (std::size_t i = b; i < e; ++i)
+			if (!own(*values[i]))
+				values[last++] = values[i];
+		kept[t] = last - b;
+	});
+
+	// close the gaps left between the chunks
+	std::size_t size = kept[0];
+	for (std::size_t t = 1; t < threads; ++t)
+		for (std::size_t i = t * chunk, e = i + kept[t]; i < e; ++i)
+			values[size++] = values[i];
+
+	const T* const* first = values.data();
+	return build_unique<Source>(s, indirect_iterator<T>(first), indirect_iterator<T>(first + size));
+}
+
+#endif
@@ -0,0 +1,330 @@
+#ifndef SERIALIZATION_H
+#define SERIALIZATION_H
+
+#include <cstddef>     // std::size_t
+#include <cstdint>     // std::uint32_t, std::uint64_t
+#include <cstring>     // std::memcpy, std::memcmp
+#include <istream>     // std::istream
+#include <iterator>    // std::iterator_traits, std::make_move_iterator
+#include <ostream>     // std::ostream
+#include <string>      // std::string
+#include <type_traits> // std::is_trivially_copyable, std::enable_if
+#include <vector>      // std::vector
+#include "set.h"
+#include "invalid_image_exception.h"
+#include "student.h"
+
+/**
+	@file serialization.h
+	@brief Declaration of the binary images of the sets and of their codecs
+
+	An image is a header, the elements in the order of the set and, if it
+	was asked for, a hash index of the elements:
+
+	- header: the magic "SET1", the version, the size of a record (0 if the
+	  records have different sizes), the number of elements and the number
+	  of slots of the index (0 if there is none), 32 bytes in all;
+	- records: the elements, each one written by the codec of its type;
+	- index: if the records have a fixed size, aligned to 4 bytes, a table
+	  of 32 bit slots holding the position of an element plus one (0 if
+	  empty), found by linear probing from the Fibonacci hash of the element.
+
+	Numbers are written in the byte order of the machine, so images are
+	meant to be read on the same kind of machine that wrote them, and the
+	index only works with the same hash functor. A mapped_set reads images
+	of fixed-size records in place.
+**/
+
+/**
+	@brief Codec of the elements of a set in a binary image
+
+	A codec tells whether all the records have the same size and writes and
+	reads one element; it is specialized for each type of element.
+	The primary template is for trivially copyable types, whose records are
+	their bytes.
+
+	@tparam T the type of the elements
+*/
+template <typename T, typename = void>
+struct codec;
+
+template <typename T>
+struct codec<T, typename std::enable_if<std::is_trivially_copyable<T>::value>::type>
+{
+	/// all the records have the same size, sizeof(T)
+	static const bool fixed_size = true;
+
+	/**
+		@brief Write a value
+
+		@param os the output stream, opened in binary mode
+		@param value the value to write
+	*/
+	static void write(std::ostream &os, const T &value)
+	{
+		os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	/**
+		@brief Read a value
+
+		@param is the input stream, opened in binary mode
+		@return the value read
+		@throw invalid_image_exception if the stream ends before the value
+	*/
+	static T read(std::istream &is)
+	{
+		T value;
+		if (!is.read(reinterpret_cast<char*>(&value), sizeof(T)))
+			throw invalid_image_exception("truncated set image");
+		return value;
+	}
+};
+
+/**
+	@brief Codec of strings: the length, in 32 bits, and the characters
+*/
+template <>
+struct codec<std::string>
+{
+	/// the records have different sizes
+	static const bool fixed_size = false;
+
+	/**
+		@brief Write a string
+
+		@param os the output stream, opened in binary mode
+		@param value the string to write
+	*/
+	static void write(std::ostream &os, const std::string &value)
+	{
+		std::uint32_t length = static_cast<std::uint32_t>(value.size());
+		os.write(reinterpret_cast<const char*>(&length), sizeof(length));
+		os.write(value.data(), length);
+	}
+
+	/**
+		@brief Read a string
+
+		@param is the input stream, opened in binary mode
+		@return the string read
+		@throw invalid_image_exception if the stream ends before the string
+	*/
+	static std::string read(std::istream &is)
+	{
+		std::uint32_t length;
+		if (!is.read(reinterpret_cast<char*>(&length), sizeof(length)))
+			throw invalid_image_exception("truncated set image");
+		std::string value(length, '\0');
+		if (length != 0 && !is.read(&value[0], length))
+			throw invalid_image_exception("truncated set image");
+		return value;
+	}
+};
+
+
+/**
+	@brief Codec of students: the age, in 32 bits, and the name
+*/
+template <>
+struct codec<student>
+{
+	/// the records have different sizes
+	static const bool fixed_size = false;
+
+	/**
+		@brief Write a student
+
+		@param os the output stream, opened in binary mode
+		@param value the student to write
+	*/
+	static void write(std::ostream &os, const student &value)
+	{
+		codec<unsigned int>::write(os, value.age);
+		codec<std::string>::write(os, value.name);
+	}
+
+	/**
+		@brief Read a student
+
+		@param is the input stream, opened in binary mode
+		@return the student read
+		@throw invalid_image_exception if the stream ends before the student
+	*/
+	static student read(std::istream &is)
+	{
+		unsigned int age = codec<unsigned int>::read(is);
+		return student(age, codec<std::string>::read(is));
+	}
+};
+
+
+/**
+	@brief Header of a binary image of a set
+*/
+struct set_image_header
+{
+	char magic[4];               ///< "SET1"
+	std::uint32_t version;       ///< version of the format, 1
+	std::uint32_t recordSize;    ///< size of a record, 0 if they have different sizes
+	std::uint32_t reserved;      ///< 0, it keeps the records aligned to 32 bytes
+	std::uint64_t count;         ///< number of elements
+	std::uint64_t slotCount;     ///< number of slots of the index, 0 if there is none
+
+	/// the magic bytes of the images
+	static const char* expected_magic()
+	{
+		return "SET1";
+	}
+
+	/// check whether the header is of an image that can be read
+	bool valid() const
+	{
+		return std::memcmp(magic, expected_magic(), 4) == 0 && version == 1;
+	}
+};
+
+static_assert(sizeof(set_image_header) == 32, "the header of a set image must be 32 bytes long");
+
+
+/**
+	@brief Slot of the index of an image for a hash
+
+	@param hash the hash of an element
+	@param slotBits log2 of the number of slots
+	@return the first slot to probe
+*/
+inline std::size_t image_home_slot(std::size_t hash, unsigned int slotBits)
+{
+	if (slotBits == 0)
+		return 0;
+	return static_cast<std::size_t>((static_cast<std::uint64_t>(hash) * 11400714819323198485ull) >> (64 - slotBits));
+}
+
+
+/**
+	@brief Helper function used to write the header and the records of an image
+
+	@tparam Source the type of the set
+	@param os the output stream, opened in binary mode
+	@param s the set
+	@param slotCount the number of slots of the index that will follow
+*/
+template <typename Source>
+void write_image_records(std::ostream &os, const Source &s, std::uint64_t slotCount)
+{
+	typedef typename std::iterator_traits<typename Source::const_iterator>::value_type T;
+
+	set_image_header header;
+	std::memcpy(header.magic, set_image_header::expected_magic(), 4);
+	header.version = 1;
+	header.recordSize = codec<T>::fixed_size ? static_cast<std::uint32_t>(sizeof(T)) : 0;
+	header.reserved = 0;
+	header.count = s.size();
+	header.slotCount = slotCount;
+	os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	for (typename Source::const_iterator ib = s.begin(), ie = s.end(); ib != ie; ++ib)
+		codec<T>::write(os, *ib);
+}
+
+
+/**
+	@brief Write a binary image of a set
+
+	The elements are written in the order of the set by their codec,
+	with no index.
+
+	@tparam Source the type of the set, a set, a flat_set, an ordered_set or a small_set
+	@param os the output stream, opened in binary mode
+	@param s the set
+*/
+template <typename Source>
+void serialize(std::ostream &os, const Source &s)
+{
+	write_image_records(os, s, 0);
+}
+
+
+/**
+	@brief Write a binary image of a set with a hash index
+
+	The index lets a mapped_set look elements up in constant time; it is
+	written only for elements with fixed-size records and it is sized for
+	a load factor of at most 1/2.
+
+	@tparam Source the type of the set, a set, a flat_set, an ordered_set or a small_set
+	@tparam Hash functor used to compute the hash of an element, the same of the mapped_set
+	@param os the output stream, opened in binary mode
+	@param s the set
+	@param hash the hash functor
+*/
+template <typename Source, typename Hash>
+void serialize(std::ostream &os, const Source &s, Hash hash)
+{
+	typedef typename std::iterator_traits<typename Source::const_iterator>::value_type T;
+	if (!codec<T>::fixed_size)
+	{
+		serialize(os, s);
+		return;
+	}
+
+	unsigned int bits = 0;
+	while ((std::size_t(1) << bits) < 2 * static_cast<std::size_t>(s.size()))
+		++bits;
+	std::vector<std::uint32_t> slots(std::size_t(1) << bits, 0);
+	std::size_t mask = slots.size() - 1;
+	std::uint32_t position = 0;
+	for (typename Source::const_iterator ib = s.begin(), ie = s.end(); ib != ie; ++ib)
+	{
+		std::size_t i = image_home_slot(hash(*ib), bits);
+		while (slots[i] != 0)
+			i = (i + 1) & mask;
+		slots[i] = ++position;
+	}
+
+	write_image_records(os, s, slots.size());
+	std::size_t end = sizeof(set_image_header) + static_cast<std::size_t>(s.size()) * sizeof(T);
+	static const char padding[4] = {0, 0, 0, 0};
+	os.write(padding, (4 - end % 4) % 4);
+	os.write(reinterpret_cast<const char*>(slots.data()), slots.size() * sizeof(std::uint32_t));
+}
+
+
+/**
+	@brief Read a binary image of a set
+
+	The elements are read in order by their codec and added to the new
+	set. An image comes from outside the program, so the elements are
+	still checked for duplicates: an image holding the same element twice
+	is refused, rather than giving a set with duplicated elements.
+	The index, if any, is skipped.
+
+	@tparam Set the type of the set to build
+	@param is the input stream, opened in binary mode
+	@return the new set
+	@throw invalid_image_exception if the image is not an image of this type of set, it is truncated or it holds duplicated elements
+	@throw std::exception
+*/
+template <typename Set>
+Set deserialize(std::istream &is)
+{
+	typedef typename std::iterator_traits<typename Set::const_iterator>::value_type T;
+
+	set_image_header header;
+	if (!is.read(reinterpret_cast<char*>(&header), sizeof(header)) || !header.valid())
+		throw invalid_image_exception("not a set image");
+	if (header.recordSize != (codec<T>::fixed_size ? sizeof(T) : 0))
+		throw invalid_image_exception("set image of another type");
+
+	std::vector<T> values;
+	// a damaged count must not be trusted for the allocation
+	values.reserve(static_cast<std::size_t>(header.count < 1048576 ? header.count : 1048576));
+	for (std::uint64_t i = 0; i < header.count; ++i)
+		values.push_back(codec<T>::read(is));
+	Set result(std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()), insert_or_ignore);
+	if (result.size() != values.size())
+		throw invalid_image_exception("set image with duplicated elements");
+	return result;
+}
+
+#endif
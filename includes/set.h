@@ -2,18 +2,79 @@
 #define SET_H
 
 #include <algorithm> // std::swap
+#include <utility>   // std::move, std::forward
 #include <cassert>   // assert()
 #include <ostream>   // std::ostream
 #include <iterator>  // std::bidirectional_iterator_tag
-#include <cstddef>   // std::ptrdiff_t
+#include <cstddef>   // std::ptrdiff_t, std::size_t
+#include <atomic>    // std::atomic
+#include <type_traits> // std::conditional, std::is_same
+#include <memory>    // std::allocator, std::allocator_traits
+#include <memory_resource> // std::pmr::polymorphic_allocator
+#include <vector>    // std::vector
 #include "non_existent_element_exception.h"
 #include "duplicated_element_exception.h"
+#include "node_pool.h"
+#include "filter_view.h"
+#include "parallel_filter.h"
+#include "set_stats.h"
+#include "set_metrics.h"
 
 /**
 	@file set.h
 	@brief Declaration of set class
 **/
 
+/**
+	@brief Placeholder hash functor
+
+	It is the default Hash parameter of set and it means that the set 
+	keeps no hash index: elements are looked up by scanning the whole
+	sequence with the equality functor.
+
+	@tparam T the type of the element stored.
+*/
+template <typename T>
+struct no_hash 
+{};
+
+
+/**
+	@brief Tag asking to skip duplicated elements instead of throwing
+
+	It can be passed to the range constructors and to plus, which then 
+	keep the first occurrence of each value and never throw 
+	duplicated_element_exception.
+*/
+struct insert_or_ignore_t 
+{};
+
+/// Value of the insert_or_ignore_t tag
+inline constexpr insert_or_ignore_t insert_or_ignore = insert_or_ignore_t();
+
+
+/**
+	@brief Number of elements of a range, if it can be counted
+
+	The range is counted only if it can be traversed more than once,
+	that is if Q is at least a forward iterator.
+
+	@tparam Q the type of the iterator
+	@param b begin iterator
+	@param e end iterator
+	@return the number of elements between b and e, or 0 if they cannot be counted
+*/
+template <typename Q>
+std::size_t range_size_hint(Q b, Q e) 
+{
+	typedef typename std::iterator_traits<Q>::iterator_category category;
+	if constexpr (std::is_base_of<std::forward_iterator_tag, category>::value)
+		return static_cast<std::size_t>(std::distance(b, e));
+	else
+		return 0;
+}
+
+
 /**
 	@brief A dynamic set of elements.
 	
@@ -22,21 +83,57 @@
 	Internally, the elements in a set are compared using an equality functor (of type Eql).
 	forward const_iterators can be used to iterate over the elements in a set.
 
+	If a hash functor is given as Hash, the set also keeps a hash index of its
+	elements, so add, remove and lookups take average O(1) time instead of O(n).
+	Two elements that are equal according to Eql must have the same hash.
+	The elements are always kept in insertion order.
+
+	Elements and index are allocated with Alloc, rebound to the internal
+	types: any standard allocator can be used, for example 
+	std::pmr::polymorphic_allocator (see pmr_set) or node_pool_allocator 
+	(see pooled_set).
+
 	@tparam T the type of the element stored.
 	@tparam Eql functor used to check whether two elements are equal or not.
+	@tparam Hash functor used to compute the hash of an element (no_hash for no index).
+	@tparam Alloc allocator used for the storage of the set.
 */
-template <typename T, typename Eql>
+template <typename T, typename Eql, typename Hash = no_hash<T>, typename Alloc = std::allocator<T> >
 class set 
 {
 
+	/// true if and only if the set keeps a hash index of its elements
+	static const bool hashed = !std::is_same<Hash, no_hash<T> >::value;
+
+	struct element;
+
+	/** @brief Links of an element of a set without hash index */
+	struct list_links 
+	{};
+
+	/** @brief Links of an element of a set with hash index */
+	struct index_links 
+	{
+		element* prev;    ///< the previous element in the set
+		element* chain;   ///< the next element in the same bucket
+		std::size_t hash; ///< the hash of the value of the element
+
+		/** @brief Default constructor */
+		index_links() : prev(0), chain(0), hash(0) 
+		{}
+	};
+
+	typedef typename std::conditional<hashed, index_links, list_links>::type links;
+
 	/**	
 		@brief An element in the set		
 
 		Inner class used to represent a generic element of the set with a certain value. 
 		It has a pointer to the next element of the set.
 		If not specified, this pointer is null by default.
+		If the set is hashed, it is also linked to its bucket of the index.
 	*/
-	struct element 
+	struct element : links 
 	{	
 		T value;	///< the value of the element
 		element* next;  ///< the next element in the set
@@ -45,88 +142,454 @@ class set
 		element() : value(0), next(0) 
 		{}
 		
-		/** @brief Secondary constructor */
-		element(const T& val, element* nextEle = 0) 
-			: value(val), next(nextEle) 
+		/** @brief Secondary constructor, it builds the value in place from args */
+		template <typename... Args>
+		explicit element(Args&&... args) 
+			: value(std::forward<Args>(args)...), next(0) 
 		{}
 	};
 
+	typedef typename std::allocator_traits<Alloc>::template rebind_alloc<element> node_allocator;
+	typedef std::allocator_traits<node_allocator> node_traits;
+	typedef typename node_traits::template rebind_alloc<element*> bucket_allocator;
+	typedef std::allocator_traits<bucket_allocator> bucket_traits;
+
 	element* _head;				///< The first element of the set
+	element* _tail;				///< The last element of the set
 	unsigned int _size;  ///< Size of the set
 
+	element** _buckets;         ///< Buckets of the hash index (only if hashed)
+	std::size_t _bucketCount;   ///< Number of buckets, always 0 or a power of 2
+	unsigned int _bucketBits;   ///< log2 of the number of buckets
+	unsigned long long _stamp;  ///< Identifies the current positions of the elements
+
+	/**
+		@brief A position of a set remembered by operator[]
+
+		It is valid as long as the set keeps the stamp it had when the 
+		cursor was taken: the stamp changes whenever an element changes position.
+	*/
+	struct cursor 
+	{
+		unsigned long long stamp; ///< the stamp of the set when the cursor was taken
+		const element* ele;       ///< the element at the position
+		unsigned int index;       ///< the position
+	};
+
+	/// number of cursors remembered by each thread
+	static const unsigned int cursorCount = 4;
+
 	Eql _equal;                 ///< Functor used to check whether two elements are equal or not
+	Hash _hash;                 ///< Functor used to compute the hash of an element
+	node_allocator _alloc;      ///< Allocator used for the elements and the index
 
 
 	/**
-		Helper function used to add an element to the set. Its functioning is
-		recursive. 
-		Note that if there's already an element in the set with the same value
-		as newValue, an exception will be thrown.
-		 
-		@param newValue a reference to the value of the new element to be inserted
-		@param ele a reference to an element of the set
+		Helper function used to allocate and construct a new element.
+
+		@param args the arguments used to build the value of the new element
+		@return a pointer to the new element
 	*/
-	void add(const T& newValue, element& ele) 
+	template <typename... Args>
+	element* createElement(Args&&... args) 
 	{
-		if (_equal(newValue, ele.value))
-			throw duplicated_element_exception();
-		else if (ele.next == 0) 
-			ele.next = new element(newValue);
-		else  
-			add(newValue, *ele.next);
+		element* ele = node_traits::allocate(_alloc, 1);
+		try 
+		{
+			node_traits::construct(_alloc, ele, std::forward<Args>(args)...);
+		}
+		catch (...) 
+		{
+			node_traits::deallocate(_alloc, ele, 1);
+			throw;
+		}
+		return ele;
+	}
+
+
+	/**
+		Helper function used to destroy and deallocate an element.
+
+		@param ele a pointer to the element
+	*/
+	void destroyElement(element* ele) 
+	{
+		node_traits::destroy(_alloc, ele);
+		node_traits::deallocate(_alloc, ele, 1);
+	}
+
+
+	/**
+		Helper function used to allocate an array of empty buckets.
+
+		@param count the number of buckets
+		@return a pointer to the first bucket
+	*/
+	element** allocateBuckets(std::size_t count) 
+	{
+		bucket_allocator alloc(_alloc);
+		element** buckets = bucket_traits::allocate(alloc, count);
+		std::fill(buckets, buckets + count, static_cast<element*>(0));
+		return buckets;
+	}
+
+
+	/**
+		Helper function used to deallocate the buckets of the index, if any.
+	*/
+	void deallocateBuckets() 
+	{
+		if (_buckets != 0) 
+		{
+			bucket_allocator alloc(_alloc);
+			bucket_traits::deallocate(alloc, _buckets, _bucketCount);
+		}
+	}
+
+
+	/**
+		Helper function used to remove all the elements and the index,
+		leaving the set with a size of 0.
+		If the allocator can free all its storage at once and the elements
+		need no destruction, the elements are not even visited.
+	*/
+	void destroyAll() 
+	{
+		deallocateBuckets();
+		bool released = false;
+		if constexpr (has_bulk_release<node_allocator>::value && std::is_trivially_destructible<element>::value)
+			released = _alloc.release();
+		if (!released)
+			clear(_head);
+		invalidatePositions();
+		_head = 0;
+		_tail = 0;
+		_size = 0;
+		_buckets = 0;
+		_bucketCount = 0;
+		_bucketBits = 0;
+	}
+
+
+	/**
+		Helper function used to get a new stamp, never used by any set of this type.
+
+		@return the new stamp
+	*/
+	static unsigned long long nextStamp() 
+	{
+		static std::atomic<unsigned long long> lastStamp(0);
+		return lastStamp.fetch_add(1, std::memory_order_relaxed) + 1;
+	}
+
+
+	/**
+		Helper function used to forget the cursors taken so far, called when
+		the elements change position.
+	*/
+	void invalidatePositions() 
+	{
+		_stamp = nextStamp();
+	}
+
+
+	/**
+		Helper function used to map a hash to a bucket of the index.
+		The hash is spread with a multiplicative (Fibonacci) step, so that
+		weak hashes like the identity on integers still fill every bucket.
+		
+		@pre the index has at least one bucket
+		@param h the hash of a value
+		@return the position of the bucket
+	*/
+	std::size_t bucketOf(std::size_t h) const 
+	{
+		if (_bucketBits == 0)
+			return 0;
+		unsigned long long spread = static_cast<unsigned long long>(h) * 11400714819323198485ull;
+		return static_cast<std::size_t>(spread >> (64 - _bucketBits));
+	}
+
+
+	/**
+		Helper function used to look up a value in the hash index.
+		
+		@param value the value to look for
+		@param h the hash of value
+		@return the element holding value, or 0 if there is none
+	*/
+	element* lookup(const T& value, std::size_t h) const 
+	{
+		if (_bucketCount == 0)
+			return 0;
+		element* ele = _buckets[bucketOf(h)];
+		for (; ele != 0; ele = ele->chain) 
+		{
+			SET_METRICS_VISITS(1);
+			if (ele->hash == h && (SET_METRICS_EQUAL(), _equal(value, ele->value)))
+				break;
+		}
+		return ele;
+	}
+
+
+	/**
+		Helper function used to look up a value in the set.
+		If the set is hashed the index is used, otherwise the elements are
+		scanned until the value is found.
+		
+		@param value the value to look for
+		@return the element holding value, or 0 if there is none
+	*/
+	element* findElement(const T& value) const 
+	{
+		if constexpr (hashed)
+			return lookup(value, _hash(value));
+		else 
+		{
+			element* ele = _head;
+			for (; ele != 0; ele = ele->next) 
+			{
+				SET_METRICS_VISITS(1);
+				SET_METRICS_EQUAL();
+				if (_equal(value, ele->value))
+					break;
+			}
+			return ele;
+		}
+	}
+
+
+	/**
+		Helper function used to insert an element into its bucket.
+		
+		@param ele the element to be indexed, whose hash is already set
+	*/
+	void link(element* ele) 
+	{
+		element*& bucket = _buckets[bucketOf(ele->hash)];
+		ele->chain = bucket;
+		bucket = ele;
+	}
+
+
+	/**
+		Helper function used to take an element out of its bucket.
+		
+		@param ele the element to be removed from the index
+	*/
+	void unlink(element* ele) 
+	{
+		element** slot = &_buckets[bucketOf(ele->hash)];
+		while (*slot != ele)
+			slot = &(*slot)->chain;
+		*slot = ele->chain;
+	}
+
+
+	/**
+		Helper function used to resize the hash index, so that it has at least
+		count buckets. All the elements are indexed again.
+
+		@param count the minimum number of buckets
+	*/
+	void rehash(std::size_t count) 
+	{
+		unsigned int bits = 0;
+		while ((std::size_t(1) << bits) < count)
+			++bits;
+		element** buckets = allocateBuckets(std::size_t(1) << bits);
+		deallocateBuckets();
+		_buckets = buckets;
+		_bucketCount = std::size_t(1) << bits;
+		_bucketBits = bits;
+		for (element* ele = _head; ele != 0; ele = ele->next)
+			link(ele);
+	}
+
+
+	/**
+		Helper function used to append a new element at the end of the set.
+		If the set is hashed, the element is also indexed and the index is
+		grown when the load factor would exceed 1.
+		If something goes wrong, the element is destroyed.
+
+		@param ele the new element, whose hash is already set if the set is hashed
+	*/
+	void append(element* ele) 
+	{
+		if constexpr (hashed) 
+		{
+			if (_size + 1 > _bucketCount)
+			{
+				try 
+				{
+					rehash(_bucketCount == 0 ? 8 : _bucketCount * 2);
+				}
+				catch (...) 
+				{
+					destroyElement(ele);
+					throw;
+				}
+			}
+			link(ele);
+			ele->prev = _tail;
+		}
+		if (_tail == 0)
+			_head = ele;
+		else
+			_tail->next = ele;
+		_tail = ele;
+		++_size;
+	}
+
+
+	/**
+		Helper function used to add an element to the set.
+		The duplicates are looked for before anything is allocated, so
+		nothing is allocated if there's already an element in the set with 
+		the same value as newValue.
+
+		@tparam V the type of the value, a reference to T
+		@param newValue the value of the new element to be inserted, copied or moved
+		@return true if the element has been added, false if it was a duplicate
+	*/
+	template <typename V>
+	bool insert(V&& newValue) 
+	{
+		SET_METRICS_SCOPE(set_op_add);
+		if constexpr (hashed) 
+		{
+			std::size_t h = _hash(newValue);
+			if (lookup(newValue, h) != 0)
+				return false;
+			element* ele = createElement(std::forward<V>(newValue));
+			ele->hash = h;
+			append(ele);
+		}
+		else 
+		{
+			if (findElement(newValue) != 0)
+				return false;
+			append(createElement(std::forward<V>(newValue)));
+		}
+		return true;
+	}
+
+
+	/**
+		Helper function used to take the first element out of the set,
+		without destroying it.
+
+		@pre the set is not empty
+		@return the element, no longer linked to the set
+	*/
+	element* detachFirst() 
+	{
+		element* ele = _head;
+		if constexpr (hashed) 
+		{
+			unlink(ele);
+			if (ele->next != 0)
+				ele->next->prev = 0;
+		}
+		_head = ele->next;
+		if (_head == 0)
+			_tail = 0;
+		ele->next = 0;
+		--_size;
+		invalidatePositions();
+		return ele;
+	}
+
+
+	/**
+		Helper function used to remove an element from a hashed set.
+
+		@param toDelete a reference to the value of the element to be deleted
+		@return false if there's no elements in the set with the same value of toDelete
+	*/
+	bool removeHashed(const T& toDelete) 
+	{
+		element* ele = lookup(toDelete, _hash(toDelete));
+		if (ele == 0)
+			return false;
+		unlink(ele);
+		if (ele->prev == 0)
+			_head = ele->next;
+		else
+			ele->prev->next = ele->next;
+		if (ele->next == 0)
+			_tail = ele->prev;
+		else
+			ele->next->prev = ele->prev;
+		destroyElement(ele);
+		return true;
 	}
 
 
 	/**
 		Helper function used to remove an element to the set. Its functioning is
-		recursive. 
-		Note that if there's no elements in the list with the same value of
-		toDelete, an exception will be thrown.
+		iterative, so it runs in constant stack space whatever the size of the set. 
 		
 		@param toDelete a reference to the value of the element to be deleted
-		@param ele a reference to an element of the set
+		@param ele a reference to the element of the set where the scan starts
+		@return false if there's no elements after ele with the same value of toDelete
 	*/
-	void remove(const T& toDelete, element &ele) 
+	bool remove(const T& toDelete, element &ele) 
 	{
-		if (ele.next == 0)
-			throw non_existent_element_exception();
-		else if (_equal(toDelete, ele.next->value)) 
+		element* previous = &ele;
+		for (; previous->next != 0; previous = previous->next) 
 		{
-			element* tmp = ele.next;
-			ele.next = ele.next->next;
-			delete tmp;
+			SET_METRICS_VISITS(1);
+			SET_METRICS_EQUAL();
+			if (_equal(toDelete, previous->next->value))
+				break;
 		}
-		else
-			remove(toDelete, *ele.next);
+		if (previous->next == 0)
+			return false;
+
+		element* tmp = previous->next;
+		previous->next = tmp->next;
+		if (_tail == tmp)
+			_tail = previous;
+		destroyElement(tmp);
+		return true;
 	}
 
 
 	/**
 		Helper function used to get an element of the set.
-		Its functioning is recursive.
+		Its functioning is iterative.
 		
-		@param ele a reference to an element
-		@param index the current index
+		@param ele a pointer to an element
+		@param index the position of the wanted element, counting from ele
+		@return a pointer to the wanted element
 	*/
-	const T& getElement(element& ele, unsigned int index) const 
+	const element* getElement(const element* ele, unsigned int index) const 
 	{
-		if (index == 0)
-			return ele.value;
-		else
-			return getElement(*ele.next, index - 1);
+		SET_METRICS_VISITS(index);
+		while (index > 0) 
+		{
+			ele = ele->next;
+			--index;
+		}
+		return ele;
 	}
 
 	/**
 		Helper function used to remove all elements in the set, leaving the set
-		with a size of 0.
+		with a size of 0. Its functioning is iterative.
 		
 		@param ele a pointer to an element in the set
 	*/
 	void clear(element* ele) 
 	{
-		if (ele != 0) {
-			clear(ele->next);
-			delete ele;
+		while (ele != 0) 
+		{
+			element* tmp = ele;
+			ele = ele->next;
+			destroyElement(tmp);
 		}
 	}
 
@@ -137,7 +600,19 @@ public:
 
 		It is used to create a new empty set.
 	*/
-	set() : _head(0), _size(0) 
+	set() : _head(0), _tail(0), _size(0), _buckets(0), _bucketCount(0), _bucketBits(0), _stamp(nextStamp()), _alloc(Alloc()) 
+	{}
+
+
+	/** 
+		@brief Allocator constructor
+
+		It is used to create a new empty set whose storage is allocated with alloc.
+
+		@param alloc the allocator used by the set
+	*/
+	explicit set(const Alloc& alloc) 
+		: _head(0), _tail(0), _size(0), _buckets(0), _bucketCount(0), _bucketBits(0), _stamp(nextStamp()), _alloc(alloc) 
 	{}
 
 
@@ -150,22 +625,28 @@ public:
 		@param other A set used to create the new one
 		@throw std::exception
 	*/
-	set(const set &other) : _head(0), _size(0) 
+	set(const set &other) 
+		: _head(0), _tail(0), _size(0), _buckets(0), _bucketCount(0), _bucketBits(0), _stamp(nextStamp()), 
+		  _alloc(node_traits::select_on_container_copy_construction(other._alloc)) 
 	{
-		element *tmp = other._head;
-		try 
-		{
-			while (tmp != 0) 
-			{
-				add(tmp->value);
-				tmp = tmp->next;
-			}	
-		}
-		catch (...) 
-		{
-			clear(_head);
-			throw;
-		}
+		copyFrom(other);
+	}
+
+
+	/** 
+		@brief Copy constructor with allocator
+
+		It is used to create a new set with the same elements 
+		of another set in input, allocated with alloc.
+
+		@param other A set used to create the new one
+		@param alloc the allocator used by the set
+		@throw std::exception
+	*/
+	set(const set &other, const Alloc& alloc) 
+		: _head(0), _tail(0), _size(0), _buckets(0), _bucketCount(0), _bucketBits(0), _stamp(nextStamp()), _alloc(alloc) 
+	{
+		copyFrom(other);
 	}
 
 
@@ -174,18 +655,24 @@ public:
 
 		It creates a set using a data sequence defined by a generic 
 		pair of iterators.
+		If the set is hashed and the sequence can be counted beforehand, the
+		index is sized once for all the elements, so the set is built in a 
+		single linear pass.
 		
 		@tparam Q the type of the iterator
 		@param b begin iterator
 		@param e end iterator
+		@param alloc the allocator used by the set
 		@throw duplicated_element_exception
 		@throw std::exception
 	*/
 	template <typename Q>
-	set(Q b, Q e) : _head(0), _size(0) 
+	set(Q b, Q e, const Alloc& alloc = Alloc()) 
+		: _head(0), _tail(0), _size(0), _buckets(0), _bucketCount(0), _bucketBits(0), _stamp(nextStamp()), _alloc(alloc) 
 	{ 
 		try 
 		{
+			reserve(range_size_hint(b, e));
 			while (b != e) 
 			{
 				add(static_cast<T>(*b));
@@ -194,61 +681,798 @@ public:
 		}
 		catch (...) 
 		{
-			clear(_head);
+			destroyAll();
 			throw;
 		}
 	}
 
 
-	/**
-		@brief Assignment operator
-		
-		It copies all the elements from other into the set, changing its size accordingly.
+	/**	
+		@brief Secondary constructor, skipping duplicates
 
-		@param other the set used to fill the current set
-		@return the current set whose elements have been modified
+		It creates a set using a data sequence defined by a generic 
+		pair of iterators. Only the first occurrence of each value is kept.
+		
+		@tparam Q the type of the iterator
+		@param b begin iterator
+		@param e end iterator
+		@param alloc the allocator used by the set
+		@throw std::exception
 	*/
-	set& operator=(const set& other) 
-	{
-		if (this != &other) 
+	template <typename Q>
+	set(Q b, Q e, insert_or_ignore_t, const Alloc& alloc = Alloc()) 
+		: _head(0), _tail(0), _size(0), _buckets(0), _bucketCount(0), _bucketBits(0), _stamp(nextStamp()), _alloc(alloc) 
+	{ 
+		try 
 		{
-			set tmp(other);
-			std::swap(_head, tmp._head);
-			std::swap(_size, tmp._size);
+			reserve(range_size_hint(b, e));
+			while (b != e) 
+			{
+				insert(static_cast<T>(*b));
+				++b;
+			}
+		}
+		catch (...) 
+		{
+			destroyAll();
+			throw;
 		}
-		return *this;
 	}
 
 
-	/**
-		@brief Destructor
+	/**	
+		@brief Secondary constructor, trusting the range to have no duplicates
 
-		It destroys all the elements in the set and deallocates all the storage capacity allocated.
-	*/
+		It creates a set using a data sequence defined by a generic 
+		pair of iterators, such as a filter_view of another set, whose 
+		elements are known to be unique: they are appended without 
+		looking for duplicates.
+		
+		@tparam Q the type of the iterator
+		@param b begin iterator
+		@param e end iterator
+		@param alloc the allocator used by the set
+		@throw std::exception
+	*/
+	template <typename Q>
+	set(Q b, Q e, assume_unique_t, const Alloc& alloc = Alloc()) 
+		: _head(0), _tail(0), _size(0), _buckets(0), _bucketCount(0), _bucketBits(0), _stamp(nextStamp()), _alloc(alloc) 
+	{ 
+		try 
+		{
+			reserve(range_size_hint(b, e));
+			while (b != e) 
+			{
+				appendUnique(static_cast<T>(*b));
+				++b;
+			}
+		}
+		catch (...) 
+		{
+			destroyAll();
+			throw;
+		}
+	}
+
+
+	/**	
+		@brief Secondary constructor, skipping duplicates, on many threads
+
+		It creates a set using a data sequence defined by a generic 
+		pair of iterators, keeping the first occurrence of each value in
+		the order of the sequence, as the constructor with insert_or_ignore.
+		The work is split among the threads of the policy: the values are
+		hashed by chunks of the sequence, the duplicates are found by hash 
+		shards, each shard on its own thread, and the elements are built by
+		chunks and stitched together in order; each shard owns its buckets of
+		the index, so no lock is ever taken.
+		It pays off on large sequences, and it takes some 40 bytes per value 
+		of temporary memory. Hash and Eql are called concurrently, so it must
+		be safe to do it. The elements are built concurrently only if the 
+		allocator is always equal, like std::allocator, and then it must be
+		safe to allocate concurrently; otherwise they are built by one thread.
+		Sets without hash index and sequences that cannot be traversed twice
+		are built by one thread.
+		
+		@tparam Q the type of the iterator
+		@param b begin iterator
+		@param e end iterator
+		@param policy the number of threads to use
+		@param alloc the allocator used by the set
+		@throw std::exception
+	*/
+	template <typename Q>
+	set(Q b, Q e, insert_or_ignore_t, parallel_policy policy, const Alloc& alloc = Alloc()) 
+		: _head(0), _tail(0), _size(0), _buckets(0), _bucketCount(0), _bucketBits(0), _stamp(nextStamp()), _alloc(alloc) 
+	{ 
+		typedef typename std::iterator_traits<Q>::iterator_category category;
+		try 
+		{
+			if constexpr (hashed && std::is_base_of<std::forward_iterator_tag, category>::value)
+				buildParallel(b, e, policy.thread_count());
+			else
+			{
+				reserve(range_size_hint(b, e));
+				while (b != e) 
+				{
+					insert(static_cast<T>(*b));
+					++b;
+				}
+			}
+		}
+		catch (...) 
+		{
+			destroyAll();
+			throw;
+		}
+	}
+
+
+	/** 
+		@brief Move constructor 
+
+		It is used to create a new set that takes the elements of another
+		set in input, without copying them. The other set is left empty.
+		It never throws, so that the containers of sets move them instead
+		of copying them when they grow.
+
+		@param other A set whose elements are taken by the new one
+	*/
+	set(set &&other) noexcept
+		: _head(0), _tail(0), _size(0), _buckets(0), _bucketCount(0), _bucketBits(0), _stamp(nextStamp()), 
+		  _alloc(std::move(other._alloc)) 
+	{
+		swapContent(other);
+	}
+
+
+	/**
+		@brief Assignment operator
+		
+		It copies all the elements from other into the set, changing its size accordingly.
+		If T is trivially copyable and the set keeps its allocator, the elements
+		of the set are overwritten in place and only the missing ones are allocated.
+
+		@param other the set used to fill the current set
+		@return the current set whose elements have been modified
+	*/
+	set& operator=(const set& other) 
+	{
+		if (this != &other) 
+		{
+			const bool propagate = node_traits::propagate_on_container_copy_assignment::value;
+			if constexpr (std::is_trivially_copyable<T>::value && std::is_copy_assignable<T>::value) 
+			{
+				if (!propagate || _alloc == other._alloc) 
+				{
+					assignInPlace(other);
+					return *this;
+				}
+			}
+			set tmp(other, propagate ? Alloc(other._alloc) : Alloc(_alloc));
+			swapContent(tmp);
+			if constexpr (propagate)
+				std::swap(_alloc, tmp._alloc);
+		}
+		return *this;
+	}
+
+
+	/**
+		@brief Move assignment operator
+		
+		The set takes the elements of other, which is left empty.
+		The elements are moved one by one only if the allocator of the set
+		cannot take over the storage of other; otherwise it never throws.
+
+		@param other the set whose elements are taken
+		@return the current set whose elements have been modified
+	*/
+	set& operator=(set&& other) noexcept(node_traits::propagate_on_container_move_assignment::value || node_traits::is_always_equal::value)
+	{
+		if (this != &other) 
+		{
+			if constexpr (node_traits::propagate_on_container_move_assignment::value) 
+			{
+				destroyAll();
+				_alloc = std::move(other._alloc);
+				swapContent(other);
+			}
+			else if (_alloc == other._alloc) 
+			{
+				destroyAll();
+				swapContent(other);
+			}
+			else 
+			{
+				set tmp(get_allocator());
+				tmp.merge(std::move(other));
+				swapContent(tmp);
+			}
+		}
+		return *this;
+	}
+
+
+	/**
+		@brief Swap the content of two sets
+
+		It exchanges the elements of the set with the ones of other.
+
+		@param other the set whose elements are exchanged with the current set
+	*/
+	void swap(set& other) 
+	{
+		if constexpr (node_traits::propagate_on_container_swap::value)
+			std::swap(_alloc, other._alloc);
+		swapContent(other);
+	}
+
+
+	/**
+		@brief Get the allocator of the set
+
+		@return a copy of the allocator used by the set
+	*/
+	Alloc get_allocator() const 
+	{
+		return Alloc(_alloc);
+	}
+
+
+private:
+
+	/**
+		Helper function used to exchange the elements of two sets,
+		leaving their allocators untouched.
+
+		@param other the set whose elements are exchanged with the current set
+	*/
+	void swapContent(set& other) 
+	{
+		std::swap(_head, other._head);
+		std::swap(_tail, other._tail);
+		std::swap(_size, other._size);
+		std::swap(_buckets, other._buckets);
+		std::swap(_bucketCount, other._bucketCount);
+		std::swap(_bucketBits, other._bucketBits);
+		std::swap(_stamp, other._stamp);
+	}
+
+
+	/**
+		Helper function used to append a copy of an element of another set
+		whose value is known not to be in this set: duplicates are not 
+		looked for and the cached hash is reused.
+
+		@param other an element of a set of the same type
+	*/
+	void appendCopy(const element* other) 
+	{
+		element* ele = createElement(other->value);
+		if constexpr (hashed)
+			ele->hash = other->hash;
+		append(ele);
+	}
+
+
+	/**
+		Helper function used to append a value known not to be in the set,
+		without looking for duplicates.
+
+		@tparam V the type of the value, a reference to T
+		@param newValue the value of the new element, copied or moved
+	*/
+	template <typename V>
+	void appendUnique(V&& newValue) 
+	{
+		element* ele = createElement(std::forward<V>(newValue));
+		if constexpr (hashed)
+			ele->hash = _hash(ele->value);
+		append(ele);
+	}
+
+
+	/**
+		Helper function used to build a hashed set from a sequence on many
+		threads, keeping the first occurrence of each value (see the parallel
+		constructor). The set must be empty.
+
+		@tparam Q the type of the iterator, at least a forward iterator
+		@param b begin iterator
+		@param e end iterator
+		@param threads the number of threads to use
+	*/
+	template <typename Q>
+	void buildParallel(Q b, Q e, std::size_t threads) 
+	{
+		std::vector<Q> positions;
+		positions.reserve(range_size_hint(b, e));
+		for (; b != e; ++b)
+			positions.push_back(b);
+		std::size_t n = positions.size();
+		if (threads > n / 2)
+			threads = n / 2;
+		if (threads <= 1) 
+		{
+			reserve(n);
+			for (std::size_t i = 0; i < n; ++i)
+				insert(static_cast<T>(*positions[i]));
+			return;
+		}
+
+		// a few shards per thread, so that uneven shards even out
+		unsigned int shardBits = 0;
+		while ((std::size_t(1) << shardBits) < threads * 8)
+			++shardBits;
+		const std::size_t shards = std::size_t(1) << shardBits;
+		auto shardOf = [shardBits](std::size_t h) 
+		{
+			return static_cast<std::size_t>((static_cast<unsigned long long>(h) * 11400714819323198485ull) >> (64 - shardBits));
+		};
+		const std::size_t chunk = (n + threads - 1) / threads;
+
+		// hash the values by chunks, sorting their positions by shard
+		std::vector<std::size_t> hashes(n);
+		std::vector<std::vector<std::size_t> > bins(threads * shards);
+		run_parallel(threads, [&](std::size_t t) 
+		{
+			for (std::size_t i = t * chunk, end = std::min(n, i + chunk); i < end; ++i) 
+			{
+				hashes[i] = _hash(static_cast<const T&>(*positions[i]));
+				bins[t * shards + shardOf(hashes[i])].push_back(i);
+			}
+		});
+
+		// find the duplicates of each shard, visiting the positions in order 
+		// so that the first occurrence is the one kept
+		std::vector<char> keep(n, 0);
+		std::vector<std::vector<std::size_t> > kept(shards);
+		run_parallel(threads, [&](std::size_t t) 
+		{
+			for (std::size_t s = t; s < shards; s += threads) 
+			{
+				std::size_t count = 0;
+				for (std::size_t c = 0; c < threads; ++c)
+					count += bins[c * shards + s].size();
+				unsigned int tableBits = 1;
+				while ((std::size_t(1) << tableBits) < 2 * count)
+					++tableBits;
+				const std::size_t empty = n;
+				const std::size_t mask = (std::size_t(1) << tableBits) - 1;
+				std::vector<std::size_t> table(mask + 1, empty);
+				kept[s].reserve(count);
+				for (std::size_t c = 0; c < threads; ++c) 
+				{
+					const std::vector<std::size_t> &bin = bins[c * shards + s];
+					for (std::size_t k = 0; k < bin.size(); ++k) 
+					{
+						std::size_t i = bin[k];
+						std::size_t h = hashes[i];
+						// the high bits chose the shard, the next ones choose the slot
+						std::size_t slot = static_cast<std::size_t>(((static_cast<unsigned long long>(h) * 11400714819323198485ull) << shardBits) >> (64 - tableBits));
+						bool duplicated = false;
+						for (; table[slot] != empty; slot = (slot + 1) & mask) 
+						{
+							std::size_t j = table[slot];
+							if (hashes[j] == h && _equal(static_cast<const T&>(*positions[j]), static_cast<const T&>(*positions[i]))) 
+							{
+								duplicated = true;
+								break;
+							}
+						}
+						if (!duplicated) 
+						{
+							table[slot] = i;
+							keep[i] = 1;
+							kept[s].push_back(i);
+						}
+					}
+				}
+			}
+		});
+		bins.clear();
+		bins.shrink_to_fit();
+
+		std::size_t total = 0;
+		for (std::size_t s = 0; s < shards; ++s)
+			total += kept[s].size();
+		reserve(total);
+
+		// build the elements by chunks, each chunk linked in order
+		std::size_t builders = node_traits::is_always_equal::value ? threads : 1;
+		std::size_t builderChunk = (n + builders - 1) / builders;
+		std::vector<element*> nodes(n, static_cast<element*>(0));
+		std::vector<element*> firsts(builders, static_cast<element*>(0));
+		std::vector<element*> lasts(builders, static_cast<element*>(0));
+		try 
+		{
+			run_parallel(builders, [&](std::size_t t) 
+			{
+				element* last = 0;
+				for (std::size_t i = t * builderChunk, end = std::min(n, i + builderChunk); i < end; ++i) 
+				{
+					if (!keep[i])
+						continue;
+					element* ele = createElement(static_cast<T>(*positions[i]));
+					ele->hash = hashes[i];
+					nodes[i] = ele;
+					ele->prev = last;
+					if (last == 0)
+						firsts[t] = ele;
+					else
+						last->next = ele;
+					last = ele;
+				}
+				lasts[t] = last;
+			});
+		}
+		catch (...) 
+		{
+			for (std::size_t i = 0; i < n; ++i)
+				if (nodes[i] != 0)
+					destroyElement(nodes[i]);
+			throw;
+		}
+
+		// stitch the chunks together
+		for (std::size_t t = 0; t < builders; ++t) 
+		{
+			if (firsts[t] == 0)
+				continue;
+			firsts[t]->prev = _tail;
+			if (_tail == 0)
+				_head = firsts[t];
+			else
+				_tail->next = firsts[t];
+			_tail = lasts[t];
+		}
+		_size = static_cast<unsigned int>(total);
+
+		// with at least as many buckets as shards, every bucket belongs to
+		// one shard, and the shards can be indexed at the same time
+		if (_bucketBits >= shardBits) 
+		{
+			run_parallel(threads, [&](std::size_t t) 
+			{
+				for (std::size_t s = t; s < shards; s += threads)
+					for (std::size_t k = 0; k < kept[s].size(); ++k)
+						link(nodes[kept[s][k]]);
+			});
+		}
+		else 
+		{
+			for (element* ele = _head; ele != 0; ele = ele->next)
+				link(ele);
+		}
+	}
+
+
+	/**
+		Helper function used by the set algebra: it appends to the set the 
+		elements of source that are, or are not, in filter. The set must
+		have no elements in common with source.
+		If filter is hashed each element is looked up in constant time,
+		reusing the hash cached in source.
+
+		@param source the set whose elements are appended
+		@param filter the set used to select the elements of source
+		@param inFilter true to take the elements of source in filter, false to take the others
+	*/
+	void appendSelected(const set& source, const set& filter, bool inFilter) 
+	{
+		for (const element* tmp = source._head; tmp != 0; tmp = tmp->next) 
+		{
+			bool found;
+			if constexpr (hashed)
+				found = filter.lookup(tmp->value, tmp->hash) != 0;
+			else
+				found = filter.findElement(tmp->value) != 0;
+			if (found == inFilter)
+				appendCopy(tmp);
+		}
+	}
+
+
+	/**
+		Helper function used to create an empty set for the result of an 
+		operation on s1, with the allocator a copy of s1 would get and
+		room for count elements.
+
+		@param s1 the first operand
+		@param count the largest number of elements of the result
+		@return an empty set
+	*/
+	static set resultOf(const set& s1, std::size_t count) 
+	{
+		set resultSet(Alloc(node_traits::select_on_container_copy_construction(s1._alloc)));
+		resultSet.reserve(count);
+		return resultSet;
+	}
+
+	template <typename T1, typename E1, typename H1, typename A1>
+	friend set<T1, E1, H1, A1> set_union(const set<T1, E1, H1, A1> &s1, const set<T1, E1, H1, A1> &s2);
+
+	template <typename T1, typename E1, typename H1, typename A1>
+	friend set<T1, E1, H1, A1> set_intersection(const set<T1, E1, H1, A1> &s1, const set<T1, E1, H1, A1> &s2);
+
+	template <typename T1, typename E1, typename H1, typename A1>
+	friend set<T1, E1, H1, A1> set_difference(const set<T1, E1, H1, A1> &s1, const set<T1, E1, H1, A1> &s2);
+
+	template <typename T1, typename E1, typename H1, typename A1>
+	friend set<T1, E1, H1, A1> symmetric_difference(const set<T1, E1, H1, A1> &s1, const set<T1, E1, H1, A1> &s2);
+
+
+	/**
+		Helper function used to fill an empty set with the elements of other.
+		The elements of other are unique, so they are cloned in order without 
+		looking for duplicates, reusing their cached hashes, and the index is 
+		sized once. If something goes wrong, the set is left empty.
+
+		@param other the set to copy
+	*/
+	void copyFrom(const set& other) 
+	{
+		try 
+		{
+			reserve(other._size);
+			for (const element* tmp = other._head; tmp != 0; tmp = tmp->next)
+				appendCopy(tmp);
+		}
+		catch (...) 
+		{
+			destroyAll();
+			throw;
+		}
+	}
+
+
+	/**
+		Helper function used to make the set a copy of other reusing its own
+		elements, when T is trivially copyable: the values of other are
+		copied over the existing elements, only the missing elements are 
+		allocated and the extra ones are destroyed.
+		The allocations are done before the set is changed, so if something 
+		goes wrong the set is left as it was.
+
+		@param other the set to copy
+	*/
+	void assignInPlace(const set& other) 
+	{
+		reserve(other._size);
+
+		// clone the elements of other that have nowhere to go
+		const element* src = other._head;
+		for (std::size_t i = 0; i < _size && src != 0; ++i)
+			src = src->next;
+		element* extraHead = 0;
+		element* extraTail = 0;
+		try 
+		{
+			for (; src != 0; src = src->next) 
+			{
+				element* ele = createElement(src->value);
+				if constexpr (hashed) 
+				{
+					ele->hash = src->hash;
+					ele->prev = extraTail;
+				}
+				if (extraTail == 0)
+					extraHead = ele;
+				else
+					extraTail->next = ele;
+				extraTail = ele;
+			}
+		}
+		catch (...) 
+		{
+			clear(extraHead);
+			throw;
+		}
+
+		// nothing can fail from here on
+		element* last = 0;
+		element* dst = _head;
+		for (src = other._head; dst != 0 && src != 0; src = src->next, dst = dst->next) 
+		{
+			dst->value = src->value;
+			if constexpr (hashed)
+				dst->hash = src->hash;
+			last = dst;
+		}
+		if (dst != 0)
+			clear(dst);
+		if (last == 0)
+			_head = extraHead;
+		else
+			last->next = extraHead;
+		if constexpr (hashed) 
+		{
+			if (extraHead != 0)
+				extraHead->prev = last;
+		}
+		_tail = extraTail != 0 ? extraTail : last;
+		if (_tail != 0)
+			_tail->next = 0;
+		_size = other._size;
+		if constexpr (hashed) 
+		{
+			std::fill(_buckets, _buckets + _bucketCount, static_cast<element*>(0));
+			for (element* ele = _head; ele != 0; ele = ele->next)
+				link(ele);
+		}
+		invalidatePositions();
+	}
+
+
+public:
+
+
+	/**
+		@brief Destructor
+
+		It destroys all the elements in the set and deallocates all the storage capacity allocated.
+	*/
 	~set() 
 	{
-		clear(_head);
-		_head = 0;
-		_size = 0;
+		destroyAll();
+	}
+
+
+	/**
+		@brief Prepare the set for a number of elements
+
+		If the set is hashed, the index is grown so that count elements
+		fit without rebuilding it; otherwise nothing is done, because each 
+		element is allocated on its own.
+
+		@param count the number of elements expected in the set
+	*/
+	void reserve(std::size_t count) 
+	{
+		if constexpr (hashed) 
+		{
+			if (count > _bucketCount)
+				rehash(count);
+		}
+	}
+
+
+	/**	
+		@brief Add an element to the set
+
+		It adds a new element to the current set with the
+		value in input.
+
+		@param val value of the new element
+		@throw duplicated_element_exception
+	*/
+	void add(const T& val) 
+	{
+		if (!insert(val))
+			throw duplicated_element_exception();
+	}
+
+
+	/**	
+		@brief Add an element to the set, moving its value
+
+		It adds a new element to the current set, whose value is moved from val.
+		If an exception is thrown, val is left untouched.
+
+		@param val value of the new element
+		@throw duplicated_element_exception
+	*/
+	void add(T&& val) 
+	{
+		if (!insert(std::move(val)))
+			throw duplicated_element_exception();
+	}
+
+
+	/**	
+		@brief Add an element to the set, if it is not there yet
+
+		It is the same as add, but a duplicate is reported by the result 
+		instead of an exception, and nothing is allocated for it.
+
+		@param val value of the new element
+		@return true if the element has been added, false if it was already in the set
+	*/
+	bool try_add(const T& val) 
+	{
+		return insert(val);
+	}
+
+
+	/**	
+		@brief Add an element to the set moving its value, if it is not there yet
+
+		If the element is already in the set, val is left untouched.
+
+		@param val value of the new element
+		@return true if the element has been added, false if it was already in the set
+	*/
+	bool try_add(T&& val) 
+	{
+		return insert(std::move(val));
+	}
+
+
+	/**	
+		@brief Build an element in place and add it to the set
+
+		The value of the new element is built from args directly inside the set.
+
+		@tparam Args the types of the arguments
+		@param args the arguments passed to a constructor of T
+		@throw duplicated_element_exception
+	*/
+	template <typename... Args>
+	void emplace(Args&&... args) 
+	{
+		SET_METRICS_SCOPE(set_op_add);
+		element* ele = createElement(std::forward<Args>(args)...);
+		bool duplicated;
+		try 
+		{
+			if constexpr (hashed) 
+			{
+				ele->hash = _hash(ele->value);
+				duplicated = lookup(ele->value, ele->hash) != 0;
+			}
+			else
+				duplicated = findElement(ele->value) != 0;
+		}
+		catch (...) 
+		{
+			destroyElement(ele);
+			throw;
+		}
+		if (duplicated) 
+		{
+			destroyElement(ele);
+			throw duplicated_element_exception();
+		}
+		append(ele);
 	}
 
 
 	/**	
-		@brief Add an element to the set
+		@brief Move the elements of another set into the set
 
-		It adds a new element to the current set with the
-		value in input.
+		The elements of other are added at the end of the set, in their order,
+		and other is left empty. If the two sets use equal allocators the 
+		elements are just relinked, otherwise their values are moved.
 
-		@param val value of the new element
-		@throw duplicated_element_exception
+		@param other the set whose elements are taken
+		@throw duplicated_element_exception if an element of other is already 
+		in the set: the elements before it have been moved already
 	*/
-	void add(const T& val) 
+	void merge(set&& other) 
 	{
-		if (_head == 0) 
-			_head = new element(val);
-		else
-			add(val, *_head);
-		++_size;
+		const bool relink = _alloc == other._alloc;
+		while (other._head != 0) 
+		{
+			if (contains(other._head->value))
+				throw duplicated_element_exception();
+			element* ele = other.detachFirst();
+			if (relink)
+				append(ele);
+			else 
+			{
+				try 
+				{
+					insert(std::move(ele->value));
+				}
+				catch (...) 
+				{
+					other.destroyElement(ele);
+					throw;
+				}
+				other.destroyElement(ele);
+			}
+		}
 	}
 
 
@@ -263,17 +1487,43 @@ public:
 	*/
 	void remove(const T& toDelete) 
 	{
-		if (_head == 0)
+		if (!try_remove(toDelete))
 			throw non_existent_element_exception();
-		else if (_equal(toDelete, _head->value)) 
+	}
+
+
+	/**
+		@brief Delete an element from the set, if it is there
+
+		It is the same as remove, but a missing element is reported by the
+		result instead of an exception.
+
+		@param toDelete value of the element that has to be deleted
+		@return true if the element has been removed, false if it was not in the set
+	*/
+	bool try_remove(const T& toDelete) 
+	{
+		SET_METRICS_SCOPE(set_op_remove);
+		if constexpr (hashed) 
+		{
+			if (!removeHashed(toDelete))
+				return false;
+		}
+		else if (_head == 0)
+			return false;
+		else if ((SET_METRICS_EQUAL(), SET_METRICS_VISITS(1), _equal(toDelete, _head->value))) 
 		{
 			element* tmp = _head;
 			_head = _head->next;
-			delete tmp;
+			if (_tail == tmp)
+				_tail = 0;
+			destroyElement(tmp);
 		}
-		else
-			remove(toDelete, *_head);
+		else if (!remove(toDelete, *_head))
+			return false;
 		--_size;
+		invalidatePositions();
+		return true;
 	}
 
 
@@ -283,6 +1533,12 @@ public:
 		It gets the i-th element of the set.
 		The first element is at position 0. 
 		The last element  is at position size − 1.
+
+		Each thread remembers the last positions reached in a few sets, and the 
+		walk starts from the nearest one (or from the end, if the set is hashed 
+		and so doubly linked). Therefore visiting the elements in order, forward 
+		or backward, takes constant time per element.
+		Concurrent calls are safe, since the remembered positions are per thread.
 		
 		@pre it is necessary that i < size
 		@param i index of the element in the set
@@ -290,8 +1546,60 @@ public:
 	*/
 	const T& operator[](unsigned int i) const 
 	{
+		SET_METRICS_SCOPE(set_op_subscript);
 		assert(i < _size);
-		return getElement(*_head, i);
+		thread_local cursor cursors[cursorCount] = {};
+		thread_local unsigned int victim = 0;
+
+		const element* start = _head;
+		unsigned int from = 0;
+		unsigned int distance = i;
+		cursor* mine = 0;
+		for (unsigned int c = 0; c < cursorCount; ++c) 
+		{
+			if (cursors[c].stamp == _stamp) 
+			{
+				mine = &cursors[c];
+				break;
+			}
+		}
+		if (mine != 0 && mine->index <= i && i - mine->index < distance) 
+		{
+			start = mine->ele;
+			from = mine->index;
+			distance = i - from;
+		}
+		if constexpr (hashed) 
+		{
+			if (mine != 0 && mine->index > i && mine->index - i < distance) 
+			{
+				start = mine->ele;
+				from = mine->index;
+				distance = from - i;
+			}
+			if (_size - 1 - i < distance) 
+			{
+				start = _tail;
+				from = _size - 1;
+			}
+			SET_METRICS_VISITS(from > i ? from - i : 0);
+			while (from > i) 
+			{
+				start = start->prev;
+				--from;
+			}
+		}
+		const element* target = getElement(start, i - from);
+
+		if (mine == 0) 
+		{
+			mine = &cursors[victim];
+			victim = (victim + 1) % cursorCount;
+			mine->stamp = _stamp;
+		}
+		mine->index = i;
+		mine->ele = target;
+		return target->value;
 	}
 
 
@@ -308,6 +1616,87 @@ public:
 	}
 
 
+	/**
+		@brief Get the memory and structure statistics of the set
+
+		If the allocator is a node_pool_allocator, the bytes of its slabs
+		are counted, so free nodes and padding show up as fragmentation;
+		the pool may also hold nodes of other sets built with copies of
+		the allocator. Otherwise only the bytes asked to the allocator are
+		known, and the fragmentation is 0.
+		It takes O(n) time, visiting the buckets of the index.
+
+		@return the statistics
+	*/
+	set_stats stats() const 
+	{
+		set_stats result;
+		result.elements = _size;
+		result.element_bytes = sizeof(element);
+		result.storage_bytes = _size * sizeof(element);
+		result.index_bytes = _bucketCount * sizeof(element*);
+		std::size_t used = result.storage_bytes + result.index_bytes;
+		result.allocated_bytes = used;
+		if constexpr (has_node_pool<node_allocator>::value) 
+		{
+			// the index is too large to come from the pool
+			result.allocated_bytes = _alloc.pool().bytes_reserved() + result.index_bytes;
+		}
+		if (result.allocated_bytes > used)
+			result.fragmentation = 1.0 - static_cast<double>(used) / result.allocated_bytes;
+		if (_size != 0)
+			result.bytes_per_element = static_cast<double>(result.allocated_bytes) / _size;
+
+		if constexpr (hashed) 
+		{
+			result.hashed = true;
+			result.buckets = _bucketCount;
+			if (_bucketCount != 0)
+				result.load_factor = static_cast<double>(_size) / _bucketCount;
+			for (std::size_t i = 0; i < _bucketCount; ++i) 
+			{
+				std::size_t length = 0;
+				for (const element* ele = _buckets[i]; ele != 0; ele = ele->chain)
+					++length;
+				if (length >= result.chain_lengths.size())
+					result.chain_lengths.resize(length + 1, 0);
+				++result.chain_lengths[length];
+				if (length > result.longest_chain)
+					result.longest_chain = length;
+			}
+		}
+		return result;
+	}
+
+
+	/**
+		@brief Write a debug dump of the set
+
+		It writes the statistics and, if the set is hashed, the elements of
+		the first non-empty buckets of the index, one bucket per line.
+
+		@param os the output stream
+		@param buckets the number of non-empty buckets to write
+	*/
+	void dump(std::ostream &os, std::size_t buckets = 16) const 
+	{
+		os << stats();
+		if constexpr (hashed) 
+		{
+			for (std::size_t i = 0; i < _bucketCount && buckets != 0; ++i) 
+			{
+				if (_buckets[i] == 0)
+					continue;
+				os << "bucket " << i << ':';
+				for (const element* ele = _buckets[i]; ele != 0; ele = ele->chain)
+					os << ' ' << ele->value;
+				os << '\n';
+				--buckets;
+			}
+		}
+	}
+
+
 	/**	
 		@brief Forward const_iterator of the class
 
@@ -422,26 +1811,73 @@ public:
 		return const_iterator(0);
 	}
 
+
+	/**
+		@brief Check whether a value is in the set
+
+		It uses the hash index if the set has one, so it takes average O(1)
+		time; otherwise it stops at the first element equal to value.
+
+		@param value the value to look for
+		@return true if and only if an element equal to value is in the set
+	*/
+	bool contains(const T& value) const 
+	{
+		return findElement(value) != 0;
+	}
+
+
+	/**
+		@brief Find a value in the set
+
+		It returns the const_iterator pointing to the element equal to value.
+
+		@param value the value to look for
+		@return const_iterator to the element, or end() if there is none
+	*/
+	const_iterator find(const T& value) const 
+	{
+		return const_iterator(findElement(value));
+	}
+
+
+	/**
+		@brief Count the elements equal to a value
+
+		Since no duplicated elements are allowed, the result is either 0 or 1.
+
+		@param value the value to look for
+		@return the number of elements equal to value
+	*/
+	unsigned int count(const T& value) const 
+	{
+		return contains(value) ? 1 : 0;
+	}
+
 };
 
 /**	
 	@brief Stream operator <<
 
 	Overriding of operator<< to write the elements of a set on a stream.
+	Each element is followed by a newline, and the stream is not flushed;
+	write_all (bulk_writer.h) is much faster on large sets.
 	
 	@tparam T the type of elements stored in the set setToPrint
 	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam Hash functor used to compute the hash of an element
+	@tparam Alloc allocator used for the storage of the sets
 	@param os output stream on which an element is sent
 	@param setToPrint the set to be sent on the output stream
 	@return the reference of the output stream
 */
-template<typename T, typename Eql>
-std::ostream &operator<<(std::ostream &os, const set<T, Eql> &setToPrint) 
+template<typename T, typename Eql, typename Hash, typename Alloc>
+std::ostream &operator<<(std::ostream &os, const set<T, Eql, Hash, Alloc> &setToPrint) 
 {
-	typename set<T, Eql>::const_iterator ib, ie;
+	typename set<T, Eql, Hash, Alloc>::const_iterator ib, ie;
 	for (ib = setToPrint.begin(), ie = setToPrint.end(); ib!=ie; ++ib) 
 	{
-		os << *ib << std::endl;
+		os << *ib << '\n';
 	}
 	return os;
 }
@@ -452,27 +1888,23 @@ std::ostream &operator<<(std::ostream &os, const set<T, Eql> &setToPrint)
 
 	This function creates and returns a new set, whose elements come from
 	a set in input that do NOT satisfy a certain predicate.
+	It materializes s | filtered_out(pred), so the elements are appended
+	without looking for duplicates. Use the view to avoid the copy.
 	
 	@tparam T the type of elements stored in the set s
 	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam Hash functor used to compute the hash of an element
+	@tparam Alloc allocator used for the storage of the sets
 	@tparam Pred the predicate that musn't be satisfied
 	@param s the set whose elements will be analyzed and saved if they do NOT satisfy the predicate Pred
 	@return a new set containing the elements of s filtered out
 */
-template<typename T, typename Eql, typename Pred>
-set<T, Eql> filter_out(const set<T, Eql> &s, Pred pred) 
+template<typename T, typename Eql, typename Hash, typename Alloc, typename Pred>
+set<T, Eql, Hash, Alloc> filter_out(const set<T, Eql, Hash, Alloc> &s, Pred pred) 
 {
-	set<T, Eql> resultSet;
-	typename set<T, Eql>::const_iterator ib, ie;
-	ib = s.begin();
-	ie = s.end();
-	while (ib != ie) 
-	{
-		if (!pred(*ib))
-			resultSet.add(*ib);
-		++ib;
-	}
-	return resultSet;
+	SET_METRICS_SCOPE(set_op_filter_out);
+	SET_METRICS_VISITS(s.size());
+	return (s | filtered_out(pred)).materialize();
 }
 
 
@@ -484,20 +1916,23 @@ set<T, Eql> filter_out(const set<T, Eql> &s, Pred pred)
 
 	@tparam T the type of elements stored in the sets
 	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam Hash functor used to compute the hash of an element
+	@tparam Alloc allocator used for the storage of the sets
 	@param s1 the first set
 	@param s2 the second set
 	@return a new set of elements of s1 and s2
 	@throw duplicated_element_exception if an element appears more than once in the sets
 */
-template<typename T, typename Eql>
-set<T, Eql> operator+(const set<T, Eql> &s1, const set<T, Eql> &s2) 
+template<typename T, typename Eql, typename Hash, typename Alloc>
+set<T, Eql, Hash, Alloc> operator+(const set<T, Eql, Hash, Alloc> &s1, const set<T, Eql, Hash, Alloc> &s2) 
 {
+	SET_METRICS_SCOPE(set_op_plus);
 
 	// add the elements of s1
-	set<T, Eql> resultSet(s1);
+	set<T, Eql, Hash, Alloc> resultSet(s1);
 
 	// add the elements of s2
-	typename set<T, Eql>::const_iterator ib, ie;
+	typename set<T, Eql, Hash, Alloc>::const_iterator ib, ie;
 	ib = s2.begin();
 	ie = s2.end();
 	while (ib != ie) 
@@ -508,4 +1943,287 @@ set<T, Eql> operator+(const set<T, Eql> &s1, const set<T, Eql> &s2)
 	return resultSet;
 }
 
+
+/**
+	@brief Create a new set with the elements of two other sets, skipping duplicates
+
+	It is operator+ in insert_or_ignore mode: the elements of s2 that are 
+	already in s1 are skipped instead of raising an exception.
+
+	@tparam T the type of elements stored in the sets
+	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam Hash functor used to compute the hash of an element
+	@tparam Alloc allocator used for the storage of the sets
+	@param s1 the first set
+	@param s2 the second set
+	@return a new set of elements of s1 and s2, each one once
+*/
+template<typename T, typename Eql, typename Hash, typename Alloc>
+set<T, Eql, Hash, Alloc> plus(const set<T, Eql, Hash, Alloc> &s1, const set<T, Eql, Hash, Alloc> &s2, insert_or_ignore_t) 
+{
+	SET_METRICS_SCOPE(set_op_plus);
+	set<T, Eql, Hash, Alloc> resultSet(s1);
+	typename set<T, Eql, Hash, Alloc>::const_iterator ib, ie;
+	for (ib = s2.begin(), ie = s2.end(); ib != ie; ++ib)
+		resultSet.try_add(*ib);
+	return resultSet;
+}
+
+
+/**
+	@brief Create a new set with the elements of a temporary set and another set, skipping duplicates
+
+	It is operator+ in insert_or_ignore mode: the elements of s1 are taken
+	over by the new set and the elements of s2 already in s1 are skipped.
+
+	@tparam T the type of elements stored in the sets
+	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam Hash functor used to compute the hash of an element
+	@tparam Alloc allocator used for the storage of the sets
+	@param s1 the first set, a temporary
+	@param s2 the second set
+	@return a new set of elements of s1 and s2, each one once
+*/
+template<typename T, typename Eql, typename Hash, typename Alloc>
+set<T, Eql, Hash, Alloc> plus(set<T, Eql, Hash, Alloc> &&s1, const set<T, Eql, Hash, Alloc> &s2, insert_or_ignore_t) 
+{
+	SET_METRICS_SCOPE(set_op_plus);
+	set<T, Eql, Hash, Alloc> resultSet(std::move(s1));
+	typename set<T, Eql, Hash, Alloc>::const_iterator ib, ie;
+	for (ib = s2.begin(), ie = s2.end(); ib != ie; ++ib)
+		resultSet.try_add(*ib);
+	return resultSet;
+}
+
+
+/**
+	@brief Create a new set with the elements of a temporary set and another set
+
+	The elements of s1 are taken over by the new set, without copying them.
+
+	@tparam T the type of elements stored in the sets
+	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam Hash functor used to compute the hash of an element
+	@tparam Alloc allocator used for the storage of the sets
+	@param s1 the first set, a temporary
+	@param s2 the second set
+	@return a new set of elements of s1 and s2
+	@throw duplicated_element_exception if an element appears more than once in the sets
+*/
+template<typename T, typename Eql, typename Hash, typename Alloc>
+set<T, Eql, Hash, Alloc> operator+(set<T, Eql, Hash, Alloc> &&s1, const set<T, Eql, Hash, Alloc> &s2) 
+{
+	SET_METRICS_SCOPE(set_op_plus);
+	set<T, Eql, Hash, Alloc> resultSet(std::move(s1));
+	typename set<T, Eql, Hash, Alloc>::const_iterator ib, ie;
+	for (ib = s2.begin(), ie = s2.end(); ib != ie; ++ib)
+		resultSet.add(*ib);
+	return resultSet;
+}
+
+
+/**
+	@brief Create a new set with the elements of a set and a temporary set
+
+	The elements of s2 are moved into the new set, without copying them.
+
+	@tparam T the type of elements stored in the sets
+	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam Hash functor used to compute the hash of an element
+	@tparam Alloc allocator used for the storage of the sets
+	@param s1 the first set
+	@param s2 the second set, a temporary
+	@return a new set of elements of s1 and s2
+	@throw duplicated_element_exception if an element appears more than once in the sets
+*/
+template<typename T, typename Eql, typename Hash, typename Alloc>
+set<T, Eql, Hash, Alloc> operator+(const set<T, Eql, Hash, Alloc> &s1, set<T, Eql, Hash, Alloc> &&s2) 
+{
+	SET_METRICS_SCOPE(set_op_plus);
+	set<T, Eql, Hash, Alloc> resultSet(s1);
+	resultSet.merge(std::move(s2));
+	return resultSet;
+}
+
+
+/**
+	@brief Create a new set with the elements of two temporary sets
+
+	No element is copied: the new set takes over the elements of s1 
+	and the elements of s2 are moved into it.
+
+	@tparam T the type of elements stored in the sets
+	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam Hash functor used to compute the hash of an element
+	@tparam Alloc allocator used for the storage of the sets
+	@param s1 the first set, a temporary
+	@param s2 the second set, a temporary
+	@return a new set of elements of s1 and s2
+	@throw duplicated_element_exception if an element appears more than once in the sets
+*/
+template<typename T, typename Eql, typename Hash, typename Alloc>
+set<T, Eql, Hash, Alloc> operator+(set<T, Eql, Hash, Alloc> &&s1, set<T, Eql, Hash, Alloc> &&s2) 
+{
+	SET_METRICS_SCOPE(set_op_plus);
+	set<T, Eql, Hash, Alloc> resultSet(std::move(s1));
+	resultSet.merge(std::move(s2));
+	return resultSet;
+}
+
+
+/**
+	@brief Union of two sets
+
+	Unlike operator+, the elements in both sets are taken once instead of 
+	raising an exception. The result holds the elements of s1, then the 
+	elements of s2 not in s1, in their order.
+	If the sets are hashed it runs in O(n+m), otherwise in O(n*m).
+
+	@tparam T the type of elements stored in the sets
+	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam Hash functor used to compute the hash of an element
+	@tparam Alloc allocator used for the storage of the sets
+	@param s1 the first set
+	@param s2 the second set
+	@return a new set of the elements in s1 or in s2
+*/
+template<typename T, typename Eql, typename Hash, typename Alloc>
+set<T, Eql, Hash, Alloc> set_union(const set<T, Eql, Hash, Alloc> &s1, const set<T, Eql, Hash, Alloc> &s2) 
+{
+	set<T, Eql, Hash, Alloc> resultSet = set<T, Eql, Hash, Alloc>::resultOf(s1, s1.size() + s2.size());
+	for (const typename set<T, Eql, Hash, Alloc>::element* tmp = s1._head; tmp != 0; tmp = tmp->next)
+		resultSet.appendCopy(tmp);
+	resultSet.appendSelected(s2, s1, false);
+	return resultSet;
+}
+
+
+/**
+	@brief Intersection of two sets
+
+	The result holds the elements of s1 that are also in s2, in their order.
+	If the sets are hashed it runs in O(n+m), otherwise in O(n*m).
+
+	@tparam T the type of elements stored in the sets
+	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam Hash functor used to compute the hash of an element
+	@tparam Alloc allocator used for the storage of the sets
+	@param s1 the first set
+	@param s2 the second set
+	@return a new set of the elements in both s1 and s2
+*/
+template<typename T, typename Eql, typename Hash, typename Alloc>
+set<T, Eql, Hash, Alloc> set_intersection(const set<T, Eql, Hash, Alloc> &s1, const set<T, Eql, Hash, Alloc> &s2) 
+{
+	set<T, Eql, Hash, Alloc> resultSet = set<T, Eql, Hash, Alloc>::resultOf(s1, std::min(s1.size(), s2.size()));
+	resultSet.appendSelected(s1, s2, true);
+	return resultSet;
+}
+
+
+/**
+	@brief Difference of two sets
+
+	The result holds the elements of s1 that are not in s2, in their order.
+	If the sets are hashed it runs in O(n+m), otherwise in O(n*m).
+
+	@tparam T the type of elements stored in the sets
+	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam Hash functor used to compute the hash of an element
+	@tparam Alloc allocator used for the storage of the sets
+	@param s1 the first set
+	@param s2 the second set
+	@return a new set of the elements in s1 and not in s2
+*/
+template<typename T, typename Eql, typename Hash, typename Alloc>
+set<T, Eql, Hash, Alloc> set_difference(const set<T, Eql, Hash, Alloc> &s1, const set<T, Eql, Hash, Alloc> &s2) 
+{
+	set<T, Eql, Hash, Alloc> resultSet = set<T, Eql, Hash, Alloc>::resultOf(s1, s1.size());
+	resultSet.appendSelected(s1, s2, false);
+	return resultSet;
+}
+
+
+/**
+	@brief Symmetric difference of two sets
+
+	The result holds the elements of s1 not in s2, then the elements of
+	s2 not in s1, in their order.
+	If the sets are hashed it runs in O(n+m), otherwise in O(n*m).
+
+	@tparam T the type of elements stored in the sets
+	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam Hash functor used to compute the hash of an element
+	@tparam Alloc allocator used for the storage of the sets
+	@param s1 the first set
+	@param s2 the second set
+	@return a new set of the elements in just one of s1 and s2
+*/
+template<typename T, typename Eql, typename Hash, typename Alloc>
+set<T, Eql, Hash, Alloc> symmetric_difference(const set<T, Eql, Hash, Alloc> &s1, const set<T, Eql, Hash, Alloc> &s2) 
+{
+	set<T, Eql, Hash, Alloc> resultSet = set<T, Eql, Hash, Alloc>::resultOf(s1, s1.size() + s2.size());
+	resultSet.appendSelected(s1, s2, false);
+	resultSet.appendSelected(s2, s1, false);
+	return resultSet;
+}
+
+
+/** @brief Union of two sets, see set_union */
+template<typename T, typename Eql, typename Hash, typename Alloc>
+set<T, Eql, Hash, Alloc> operator|(const set<T, Eql, Hash, Alloc> &s1, const set<T, Eql, Hash, Alloc> &s2) 
+{
+	return set_union(s1, s2);
+}
+
+
+/** @brief Intersection of two sets, see set_intersection */
+template<typename T, typename Eql, typename Hash, typename Alloc>
+set<T, Eql, Hash, Alloc> operator&(const set<T, Eql, Hash, Alloc> &s1, const set<T, Eql, Hash, Alloc> &s2) 
+{
+	return set_intersection(s1, s2);
+}
+
+
+/** @brief Difference of two sets, see set_difference */
+template<typename T, typename Eql, typename Hash, typename Alloc>
+set<T, Eql, Hash, Alloc> operator-(const set<T, Eql, Hash, Alloc> &s1, const set<T, Eql, Hash, Alloc> &s2) 
+{
+	return set_difference(s1, s2);
+}
+
+
+/** @brief Symmetric difference of two sets, see symmetric_difference */
+template<typename T, typename Eql, typename Hash, typename Alloc>
+set<T, Eql, Hash, Alloc> operator^(const set<T, Eql, Hash, Alloc> &s1, const set<T, Eql, Hash, Alloc> &s2) 
+{
+	return symmetric_difference(s1, s2);
+}
+
+
+/**
+	@brief A set whose storage comes from a std::pmr::memory_resource
+
+	@tparam T the type of the element stored
+	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam Hash functor used to compute the hash of an element
+*/
+template <typename T, typename Eql, typename Hash = no_hash<T> >
+using pmr_set = set<T, Eql, Hash, std::pmr::polymorphic_allocator<T> >;
+
+
+/**
+	@brief A set whose elements are taken from its own node_pool
+
+	Freed elements are reused by the following insertions and, if the
+	elements need no destruction, the whole pool is released at once 
+	when the set is destroyed.
+
+	@tparam T the type of the element stored
+	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam Hash functor used to compute the hash of an element
+*/
+template <typename T, typename Eql, typename Hash = no_hash<T> >
+using pooled_set = set<T, Eql, Hash, node_pool_allocator<T> >;
+
 #endif
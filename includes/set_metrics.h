@@ -0,0 +1,218 @@
+#ifndef SET_METRICS_H
+#define SET_METRICS_H
+
+#include <atomic>  // std::atomic
+#include <chrono>  // std::chrono::steady_clock
+#include <cstddef> // std::size_t
+#include <ostream> // std::ostream
+
+/**
+	@file set_metrics.h
+	@brief Declaration of the instrumentation of the operations of set
+
+	The operations of set are instrumented only if SET_INSTRUMENTATION is
+	defined when compiling, for example with -DSET_INSTRUMENTATION;
+	otherwise the instrumentation macros expand to nothing and cost nothing.
+	The registry itself is always available, so that the dumps can be
+	called unconditionally.
+**/
+
+/**
+	@brief The instrumented operations of set
+*/
+enum set_operation
+{
+	set_op_add,         ///< add, try_add and emplace
+	set_op_remove,      ///< remove and try_remove
+	set_op_subscript,   ///< operator[]
+	set_op_filter_out,  ///< filter_out
+	set_op_plus,        ///< operator+ and plus
+	set_op_count        ///< number of instrumented operations
+};
+
+
+/**
+	@brief Counters and latency histogram of one operation
+
+	The latencies are counted in buckets of powers of 2 of nanoseconds:
+	bucket k counts the calls that took at most 2^k ns and more than
+	2^(k-1) ns, so that 2^k ns is its inclusive (le) bound in the dumps;
+	bucket 0 counts the calls of at most 1 ns and the last bucket all the
+	longer ones.
+	All counters are atomic and updated with relaxed ordering.
+*/
+struct set_operation_metrics
+{
+	/// number of latency buckets, the last one counting the calls longer than 2^36 ns, about 69 seconds
+	static const std::size_t latency_buckets = 38;
+
+	std::atomic<unsigned long long> calls;          ///< completed calls
+	std::atomic<unsigned long long> equal_calls;    ///< calls of Eql made by the calls
+	std::atomic<unsigned long long> nodes_visited;  ///< elements visited by the calls
+	std::atomic<unsigned long long> nanoseconds;    ///< total time of the calls
+	std::atomic<unsigned long long> latency[latency_buckets]; ///< the latency histogram
+
+	/** @brief Default constructor, all counters are 0 */
+	set_operation_metrics();
+
+	/** @brief Set all counters to 0 */
+	void reset();
+};
+
+
+/**
+	@brief Registry of the metrics of the operations of all the sets
+
+	There is one registry per program, shared by all the threads.
+*/
+class set_metrics
+{
+
+	set_operation_metrics _operations[set_op_count]; ///< The metrics of each operation
+
+	set_metrics() {}
+	set_metrics(const set_metrics &other); // not copyable
+	set_metrics& operator=(const set_metrics &other); // not assignable
+
+public:
+
+	/** @brief Get the registry of the program */
+	static set_metrics& global();
+
+	/** @brief Get the name of an operation, as used in the dumps */
+	static const char* name(set_operation op);
+
+	/** @brief Get the metrics of an operation */
+	const set_operation_metrics& operation(set_operation op) const;
+
+	/**
+		@brief Record a completed call
+
+		@param op the operation
+		@param nanoseconds the time taken by the call
+		@param equalCalls the calls of Eql made by the call
+		@param nodesVisited the elements visited by the call
+	*/
+	void record(set_operation op, unsigned long long nanoseconds, unsigned long long equalCalls, unsigned long long nodesVisited);
+
+	/** @brief Set all counters to 0 */
+	void reset();
+
+	/**
+		@brief Write the metrics as a JSON object
+
+		Each operation is a member with its counters and the nonzero
+		buckets of its histogram, as inclusive upper bound in ns and count.
+
+		@param os the output stream
+	*/
+	void write_json(std::ostream &os) const;
+
+	/**
+		@brief Write the metrics in the Prometheus text exposition format
+
+		The counters are set_operation_calls_total, set_operation_equal_calls_total
+		and set_operation_nodes_visited_total, and the latencies the histogram
+		set_operation_latency_seconds, all labelled by operation; the
+		bounds and the sums of the latencies are written with all their
+		digits, down to the nanosecond.
+
+		@param os the output stream
+	*/
+	void write_prometheus(std::ostream &os) const;
+};
+
+
+/**
+	@brief The measure of a call of an instrumented operation
+
+	It counts, on its thread, the calls of Eql and the visited elements
+	until it is destroyed, and then records them with the elapsed time.
+	If a call runs inside another instrumented call, like the adds of
+	operator+, only the outermost call is recorded, with everything done
+	by the inner ones.
+*/
+class set_metrics_scope
+{
+
+	set_operation _op;                                 ///< The operation measured
+	std::chrono::steady_clock::time_point _start;      ///< When the call started
+	bool _outermost;                                   ///< True if no other call was measured on the thread
+
+	set_metrics_scope(const set_metrics_scope &other); // not copyable
+	set_metrics_scope& operator=(const set_metrics_scope &other); // not assignable
+
+	/** @brief The counters of the current thread */
+	struct thread_counters
+	{
+		unsigned int depth;               ///< number of nested measured calls
+		unsigned long long equalCalls;    ///< calls of Eql in the outermost call
+		unsigned long long nodesVisited;  ///< elements visited in the outermost call
+	};
+
+	/** Helper function used to get the counters of the current thread */
+	static thread_counters& counters()
+	{
+		thread_local thread_counters current = { 0, 0, 0 };
+		return current;
+	}
+
+public:
+
+	/**
+		@brief Constructor, it starts measuring a call
+
+		@param op the operation
+	*/
+	explicit set_metrics_scope(set_operation op) : _op(op)
+	{
+		thread_counters &c = counters();
+		_outermost = c.depth++ == 0;
+		if (_outermost)
+		{
+			c.equalCalls = 0;
+			c.nodesVisited = 0;
+			_start = std::chrono::steady_clock::now();
+		}
+	}
+
+	/** @brief Destructor, it records the call */
+	~set_metrics_scope()
+	{
+		thread_counters &c = counters();
+		--c.depth;
+		if (_outermost)
+		{
+			std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - _start;
+			set_metrics::global().record(_op, static_cast<unsigned long long>(elapsed.count()), c.equalCalls, c.nodesVisited);
+		}
+	}
+
+	/** @brief Count a call of Eql, if a call is being measured */
+	static void count_equal()
+	{
+		++counters().equalCalls;
+	}
+
+	/** @brief Count visited elements, if a call is being measured */
+	static void count_visits(unsigned long long n)
+	{
+		counters().nodesVisited += n;
+	}
+};
+
+
+#ifdef SET_INSTRUMENTATION
+/// Measure the rest of the enclosing block as a call of op
+#define SET_METRICS_SCOPE(op) set_metrics_scope set_metrics_scope_of_call(op)
+/// Count a call of Eql
+#define SET_METRICS_EQUAL() set_metrics_scope::count_equal()
+/// Count n visited elements
+#define SET_METRICS_VISITS(n) set_metrics_scope::count_visits(n)
+#else
+#define SET_METRICS_SCOPE(op) ((void)0)
+#define SET_METRICS_EQUAL() ((void)0)
+#define SET_METRICS_VISITS(n) ((void)0)
+#endif
+
+#endif
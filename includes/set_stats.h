@@ -0,0 +1,82 @@
+#ifndef SET_STATS_H
+#define SET_STATS_H
+
+#include <cstddef> // std::size_t
+#include <ostream> // std::ostream
+#include <vector>  // std::vector
+
+/**
+	@file set_stats.h
+	@brief Declaration of set_stats struct
+**/
+
+/**
+	@brief Memory and structure statistics of a set
+
+	It is filled by the stats member function of set and flat_set.
+	Bytes are those of the storage of the set itself: the memory owned
+	by the elements, like the characters of a string, is not counted.
+*/
+struct set_stats
+{
+	std::size_t elements;         ///< number of elements
+	std::size_t element_bytes;    ///< bytes taken by one element, links included
+	std::size_t storage_bytes;    ///< bytes of the storage of the elements, unused capacity included
+	std::size_t index_bytes;      ///< bytes of the hash index, 0 if there is none
+	std::size_t allocated_bytes;  ///< bytes held by the allocator for the set, free nodes included when they are known
+	double bytes_per_element;     ///< allocated_bytes divided by elements, 0 if empty
+	double fragmentation;         ///< share of allocated_bytes not holding an element or the index, between 0 and 1
+
+	bool hashed;                  ///< true if and only if the set has a hash index
+	std::size_t buckets;          ///< number of buckets or slots of the index
+	double load_factor;           ///< elements divided by buckets, 0 if there is no index
+	std::size_t longest_chain;    ///< the most elements in a bucket, or the most probes to find an element
+
+	/// chain_lengths[k]: number of buckets holding k elements (set only)
+	std::vector<std::size_t> chain_lengths;
+
+	/// probe_lengths[k]: number of elements found by k + 1 probes (flat_set only)
+	std::vector<std::size_t> probe_lengths;
+
+	/** @brief Default constructor, statistics of an empty set with no index */
+	set_stats()
+		: elements(0), element_bytes(0), storage_bytes(0), index_bytes(0), allocated_bytes(0),
+		  bytes_per_element(0), fragmentation(0), hashed(false), buckets(0), load_factor(0), longest_chain(0)
+	{}
+};
+
+
+/**
+	@brief Stream operator <<
+
+	The statistics are written one per line, as a name and a value
+	separated by a space; the histograms as a list of length:count pairs
+	of the lengths with a nonzero count.
+
+	@param os output stream on which the statistics are sent
+	@param stats the statistics to be sent on the output stream
+	@return the reference of the output stream
+*/
+inline std::ostream &operator<<(std::ostream &os, const set_stats &stats)
+{
+	os << "elements " << stats.elements << '\n'
+	   << "element_bytes " << stats.element_bytes << '\n'
+	   << "storage_bytes " << stats.storage_bytes << '\n'
+	   << "index_bytes " << stats.index_bytes << '\n'
+	   << "allocated_bytes " << stats.allocated_bytes << '\n'
+	   << "bytes_per_element " << stats.bytes_per_element << '\n'
+	   << "fragmentation " << stats.fragmentation << '\n';
+	if (!stats.hashed)
+		return os;
+	os << "buckets " << stats.buckets << '\n'
+	   << "load_factor " << stats.load_factor << '\n'
+	   << "longest_chain " << stats.longest_chain << '\n';
+	const std::vector<std::size_t> &histogram = stats.chain_lengths.empty() ? stats.probe_lengths : stats.chain_lengths;
+	os << (stats.chain_lengths.empty() ? "probe_lengths" : "chain_lengths");
+	for (std::size_t k = 0; k < histogram.size(); ++k)
+		if (histogram[k] != 0)
+			os << ' ' << (stats.chain_lengths.empty() ? k + 1 : k) << ':' << histogram[k];
+	return os << '\n';
+}
+
+#endif
@@ -0,0 +1,210 @@
+#ifndef SIMD_FIND_H
+#define SIMD_FIND_H
+
+#include <cstddef>     // std::size_t
+#include <functional>  // std::equal_to
+#include <type_traits> // std::false_type, std::is_arithmetic, std::is_same
+
+#if defined(__GNUC__) && defined(__AVX2__)
+#include <immintrin.h>
+#define SIMD_FIND_BYTES 32
+#elif defined(__GNUC__) && defined(__SSE2__)
+#include <emmintrin.h>
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
+#define SIMD_FIND_BYTES 16
+#endif
+
+/**
+	@file simd_find.h
+	@brief Declaration of simd_find and of the is_builtin_equality trait
+
+	The vector instructions are chosen at compile time: AVX2 if the compiler
+	targets it (for example with -mavx2 or -march=native), SSE2 otherwise on
+	x86-64, and a scalar loop on the other targets.
+**/
+
+/**
+	@brief Check whether an equality functor is the built-in operator== of T
+
+	Containers use it to compare many arithmetic values with a single
+	vector instruction instead of calling the functor for each one.
+	It is true for std::equal_to; specialize it for the other functors
+	that just return a == b.
+
+	@tparam Eql the equality functor
+	@tparam T the type of the values compared
+*/
+template <typename Eql, typename T>
+struct is_builtin_equality : std::false_type
+{};
+
+template <typename T>
+struct is_builtin_equality<std::equal_to<T>, T> : std::is_arithmetic<T>
+{};
+
+template <typename T>
+struct is_builtin_equality<std::equal_to<void>, T> : std::is_arithmetic<T>
+{};
+
+
+/**
+	@brief Check whether simd_find compares values of type T with vector instructions
+
+	@tparam T the type of the values
+*/
+template <typename T>
+struct is_simd_comparable : std::integral_constant<bool,
+	std::is_arithmetic<T>::value && !std::is_same<T, bool>::value && !std::is_same<T, long double>::value>
+{};
+
+
+#ifdef SIMD_FIND_BYTES
+
+#ifdef __AVX2__
+
+typedef __m256i simd_register;
+
+inline simd_register simd_load(const void* p)
+{
+	return _mm256_loadu_si256(static_cast<const simd_register*>(p));
+}
+
+inline unsigned int simd_byte_mask(simd_register r)
+{
+	return static_cast<unsigned int>(_mm256_movemask_epi8(r));
+}
+
+template <typename T>
+simd_register simd_splat(T value)
+{
+	if constexpr (std::is_same<T, float>::value)
+		return _mm256_castps_si256(_mm256_set1_ps(value));
+	else if constexpr (std::is_same<T, double>::value)
+		return _mm256_castpd_si256(_mm256_set1_pd(value));
+	else if constexpr (sizeof(T) == 1)
+		return _mm256_set1_epi8(static_cast<char>(value));
+	else if constexpr (sizeof(T) == 2)
+		return _mm256_set1_epi16(static_cast<short>(value));
+	else if constexpr (sizeof(T) == 4)
+		return _mm256_set1_epi32(static_cast<int>(value));
+	else
+		return _mm256_set1_epi64x(static_cast<long long>(value));
+}
+
+template <typename T>
+simd_register simd_equal(simd_register a, simd_register b)
+{
+	if constexpr (std::is_same<T, float>::value)
+		return _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b), _CMP_EQ_OQ));
+	else if constexpr (std::is_same<T, double>::value)
+		return _mm256_castpd_si256(_mm256_cmp_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b), _CMP_EQ_OQ));
+	else if constexpr (sizeof(T) == 1)
+		return _mm256_cmpeq_epi8(a, b);
+	else if constexpr (sizeof(T) == 2)
+		return _mm256_cmpeq_epi16(a, b);
+	else if constexpr (sizeof(T) == 4)
+		return _mm256_cmpeq_epi32(a, b);
+	else
+		return _mm256_cmpeq_epi64(a, b);
+}
+
+#else
+
+typedef __m128i simd_register;
+
+inline simd_register simd_load(const void* p)
+{
+	return _mm_loadu_si128(static_cast<const simd_register*>(p));
+}
+
+inline unsigned int simd_byte_mask(simd_register r)
+{
+	return static_cast<unsigned int>(_mm_movemask_epi8(r));
+}
+
+template <typename T>
+simd_register simd_splat(T value)
+{
+	if constexpr (std::is_same<T, float>::value)
+		return _mm_castps_si128(_mm_set1_ps(value));
+	else if constexpr (std::is_same<T, double>::value)
+		return _mm_castpd_si128(_mm_set1_pd(value));
+	else if constexpr (sizeof(T) == 1)
+		return _mm_set1_epi8(static_cast<char>(value));
+	else if constexpr (sizeof(T) == 2)
+		return _mm_set1_epi16(static_cast<short>(value));
+	else if constexpr (sizeof(T) == 4)
+		return _mm_set1_epi32(static_cast<int>(value));
+	else
+		return _mm_set1_epi64x(static_cast<long long>(value));
+}
+
+template <typename T>
+simd_register simd_equal(simd_register a, simd_register b)
+{
+	if constexpr (std::is_same<T, float>::value)
+		return _mm_castps_si128(_mm_cmpeq_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b)));
+	else if constexpr (std::is_same<T, double>::value)
+		return _mm_castpd_si128(_mm_cmpeq_pd(_mm_castsi128_pd(a), _mm_castsi128_pd(b)));
+	else if constexpr (sizeof(T) == 1)
+		return _mm_cmpeq_epi8(a, b);
+	else if constexpr (sizeof(T) == 2)
+		return _mm_cmpeq_epi16(a, b);
+	else if constexpr (sizeof(T) == 4)
+		return _mm_cmpeq_epi32(a, b);
+	else
+	{
+#ifdef __SSE4_1__
+		return _mm_cmpeq_epi64(a, b);
+#else
+		// both halves of a 64 bit lane must be equal
+		simd_register halves = _mm_cmpeq_epi32(a, b);
+		return _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+#endif
+	}
+}
+
+#endif
+
+#endif
+
+
+/**
+	@brief Find a value in an array of arithmetic values
+
+	The values are compared with operator==, a whole vector register at a
+	time when is_simd_comparable<T> holds and the target has SSE2 or AVX2,
+	and one by one otherwise.
+
+	@tparam T the type of the values
+	@param data the array, with no alignment requirements
+	@param n the number of values in the array
+	@param value the value to look for
+	@return the position of the first value equal to value, or n if there is none
+*/
+template <typename T>
+std::size_t simd_find(const T* data, std::size_t n, T value)
+{
+	std::size_t i = 0;
+#ifdef SIMD_FIND_BYTES
+	if constexpr (is_simd_comparable<T>::value)
+	{
+		const std::size_t lanes = SIMD_FIND_BYTES / sizeof(T);
+		simd_register key = simd_splat(value);
+		for (; i + lanes <= n; i += lanes)
+		{
+			unsigned int mask = simd_byte_mask(simd_equal<T>(simd_load(data + i), key));
+			if (mask != 0)
+				return i + __builtin_ctz(mask) / sizeof(T);
+		}
+	}
+#endif
+	for (; i < n; ++i)
+		if (data[i] == value)
+			return i;
+	return n;
+}
+
+#endif
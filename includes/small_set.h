@@ -0,0 +1,714 @@
+#ifndef SMALL_SET_H
+#define SMALL_SET_H
+
+#include <cassert>     // assert()
+#include <cstddef>     // std::size_t
+#include <new>         // placement new
+#include <ostream>     // std::ostream
+#include <type_traits> // std::aligned_storage, std::is_nothrow_move_constructible
+#include <utility>     // std::move, std::forward, std::move_if_noexcept
+#include <vector>      // std::vector
+#include "set.h"
+#include "simd_find.h"
+#include "non_existent_element_exception.h"
+#include "duplicated_element_exception.h"
+
+/**
+	@file small_set.h
+	@brief Declaration of small_set class
+**/
+
+/**
+	@brief A dynamic set of elements stored inside the object while they are few.
+
+	It has the same interface of set, but the first N elements are kept in a
+	buffer inside the set itself, so a set that never grows beyond N elements
+	makes no heap allocation at all. When the (N+1)-th element is added, all
+	the elements are moved to a heap array, where they stay from then on.
+	Either way the elements are contiguous and in insertion order, and
+	lookups scan them, with vector instructions when T is arithmetic and Eql
+	is its built-in equality (see is_builtin_equality): it is meant for sets
+	of a handful of elements, flat_set is better for the larger ones.
+
+	@tparam T the type of the element stored.
+	@tparam Eql functor used to check whether two elements are equal or not.
+	@tparam N the number of elements stored inside the set.
+*/
+template <typename T, typename Eql, std::size_t N = 8>
+class small_set
+{
+	static_assert(N > 0, "a small_set must hold at least one element inline");
+
+	/// true if and only if the elements are scanned with simd_find
+	static const bool vectorized = is_builtin_equality<Eql, T>::value && is_simd_comparable<T>::value;
+
+	/// value returned by the lookups that find nothing
+	static const std::size_t npos = static_cast<std::size_t>(-1);
+
+	typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type cell;
+
+	cell _inline[N];        ///< The storage of the elements before they spill
+	std::size_t _size;      ///< Number of elements, wherever they are
+	bool _spilled;          ///< true if and only if the elements are in _heap
+	std::vector<T> _heap;   ///< The elements, once they have spilled
+
+	Eql _equal;             ///< Functor used to check whether two elements are equal or not
+
+
+	/** Helper function used to get the address of an inline cell */
+	T* inlineAt(std::size_t i)
+	{
+		return reinterpret_cast<T*>(&_inline[i]);
+	}
+
+
+	/** Helper function used to get the address of the elements */
+	T* data()
+	{
+		return _spilled ? _heap.data() : inlineAt(0);
+	}
+
+
+	/** Helper function used to get the address of the elements */
+	const T* data() const
+	{
+		return _spilled ? _heap.data() : reinterpret_cast<const T*>(&_inline[0]);
+	}
+
+
+	/**
+		Helper function used to find the position of a value.
+
+		@param value the value to look for
+		@return the position of value, or npos if it is not in the set
+	*/
+	std::size_t position(const T& value) const
+	{
+		const T* values = data();
+		if constexpr (vectorized)
+		{
+			std::size_t i = simd_find(values, _size, value);
+			return i == _size ? npos : i;
+		}
+		else
+		{
+			for (std::size_t i = 0; i < _size; ++i)
+				if (_equal(value, values[i]))
+					return i;
+			return npos;
+		}
+	}
+
+
+	/**
+		Helper function used to move the elements from the inline buffer to
+		the heap array. If something goes wrong, the set is left as it was.
+	*/
+	void spill()
+	{
+		std::vector<T> heap;
+		heap.reserve(2 * N);
+		for (std::size_t i = 0; i < _size; ++i)
+			heap.push_back(std::move_if_noexcept(*inlineAt(i)));
+		for (std::size_t i = 0; i < _size; ++i)
+			inlineAt(i)->~T();
+		_heap.swap(heap);
+		_spilled = true;
+	}
+
+
+	/**
+		Helper function used to append a value known not to be in the set,
+		without looking for duplicates.
+
+		@tparam V the type of the value, a reference to T
+		@param newValue the value of the new element, copied or moved
+	*/
+	template <typename V>
+	void appendUnique(V&& newValue)
+	{
+		if (!_spilled && _size == N)
+			spill();
+		if (_spilled)
+			_heap.push_back(std::forward<V>(newValue));
+		else
+			::new (static_cast<void*>(inlineAt(_size))) T(std::forward<V>(newValue));
+		++_size;
+	}
+
+
+	/**
+		Helper function used to add an element to the set.
+		The duplicates are looked for before the storage is touched.
+
+		@tparam V the type of the value, a reference to T
+		@param newValue the value of the new element to be inserted, copied or moved
+		@return true if the element has been added, false if it was a duplicate
+	*/
+	template <typename V>
+	bool insert(V&& newValue)
+	{
+		if (position(newValue) != npos)
+			return false;
+		appendUnique(std::forward<V>(newValue));
+		return true;
+	}
+
+
+	/**
+		Helper function used to destroy all the elements and give back the heap
+		array, so that the set goes back to its inline buffer.
+	*/
+	void reset()
+	{
+		if (_spilled)
+			std::vector<T>().swap(_heap);
+		else
+			for (std::size_t i = 0; i < _size; ++i)
+				inlineAt(i)->~T();
+		_size = 0;
+		_spilled = false;
+	}
+
+
+	/**
+		Helper function used to take the elements of other, which is left
+		empty. The set must be empty and not spilled.
+
+		@param other the set whose elements are taken
+	*/
+	void take(small_set& other)
+	{
+		if (other._spilled)
+		{
+			_heap.swap(other._heap);
+			_spilled = true;
+			_size = other._size;
+		}
+		else
+		{
+			try
+			{
+				for (std::size_t i = 0; i < other._size; ++i)
+				{
+					::new (static_cast<void*>(inlineAt(i))) T(std::move(*other.inlineAt(i)));
+					++_size;
+				}
+			}
+			catch (...)
+			{
+				reset();
+				throw;
+			}
+		}
+		other.reset();
+	}
+
+public:
+
+	/// The iterator of the set, a pointer to its elements
+	typedef const T* const_iterator;
+
+	/**
+		@brief Default constructor
+
+		It creates an empty set, with no allocation.
+	*/
+	small_set() : _size(0), _spilled(false)
+	{}
+
+
+	/**
+		@brief Copy constructor
+
+		The elements of other are copied in order without looking for duplicates,
+		inside the new set if they fit, or else in bulk into a heap array.
+
+		@param other A set used to create the new one
+		@throw std::exception
+	*/
+	small_set(const small_set &other) : _size(0), _spilled(false)
+	{
+		const T* values = other.data();
+		if (other._size > N)
+		{
+			_heap.assign(values, values + other._size);
+			_spilled = true;
+			_size = other._size;
+			return;
+		}
+		try
+		{
+			for (std::size_t i = 0; i < other._size; ++i)
+				appendUnique(values[i]);
+		}
+		catch (...)
+		{
+			reset();
+			throw;
+		}
+	}
+
+
+	/**
+		@brief Move constructor
+
+		A spilled set hands its heap array over; otherwise the elements are
+		moved one by one into the new set. other is left empty.
+		It never throws if the moves of T don't, so that the containers of
+		sets move them instead of copying them when they grow.
+
+		@param other the set whose elements are taken
+	*/
+	small_set(small_set &&other) noexcept(std::is_nothrow_move_constructible<T>::value) : _size(0), _spilled(false)
+	{
+		take(other);
+	}
+
+
+	/**
+		@brief Secondary constructor
+
+		It creates a set using a data sequence defined by a generic
+		pair of iterators.
+
+		@tparam Q the type of the iterator
+		@param b begin iterator
+		@param e end iterator
+		@throw duplicated_element_exception
+		@throw std::exception
+	*/
+	template <typename Q>
+	small_set(Q b, Q e) : _size(0), _spilled(false)
+	{
+		try
+		{
+			while (b != e)
+			{
+				add(static_cast<T>(*b));
+				++b;
+			}
+		}
+		catch (...)
+		{
+			reset();
+			throw;
+		}
+	}
+
+
+	/**
+		@brief Secondary constructor, skipping duplicates
+
+		Only the first occurrence of each value of the sequence is kept.
+
+		@tparam Q the type of the iterator
+		@param b begin iterator
+		@param e end iterator
+		@throw std::exception
+	*/
+	template <typename Q>
+	small_set(Q b, Q e, insert_or_ignore_t) : _size(0), _spilled(false)
+	{
+		try
+		{
+			while (b != e)
+			{
+				insert(static_cast<T>(*b));
+				++b;
+			}
+		}
+		catch (...)
+		{
+			reset();
+			throw;
+		}
+	}
+
+
+	/**
+		@brief Secondary constructor, trusting the range to have no duplicates
+
+		The elements of the sequence, such as a filter_view of another set,
+		are known to be unique, so they are appended without looking for
+		duplicates.
+
+		@tparam Q the type of the iterator
+		@param b begin iterator
+		@param e end iterator
+		@throw std::exception
+	*/
+	template <typename Q>
+	small_set(Q b, Q e, assume_unique_t) : _size(0), _spilled(false)
+	{
+		try
+		{
+			while (b != e)
+			{
+				appendUnique(static_cast<T>(*b));
+				++b;
+			}
+		}
+		catch (...)
+		{
+			reset();
+			throw;
+		}
+	}
+
+
+	/**
+		@brief Destructor
+
+		It destroys the elements and frees the heap array, if any.
+	*/
+	~small_set()
+	{
+		reset();
+	}
+
+
+	/**
+		@brief Assignment operator
+
+		@param other the set used to fill the current set
+		@return the current set whose elements have been modified
+	*/
+	small_set& operator=(const small_set &other)
+	{
+		if (this != &other)
+		{
+			small_set tmp(other);
+			reset();
+			take(tmp);
+		}
+		return *this;
+	}
+
+
+	/**
+		@brief Move assignment operator
+
+		It never throws if the moves of T don't.
+
+		@param other the set whose elements are taken
+		@return the current set whose elements have been modified
+	*/
+	small_set& operator=(small_set &&other) noexcept(std::is_nothrow_move_constructible<T>::value)
+	{
+		if (this != &other)
+		{
+			reset();
+			take(other);
+		}
+		return *this;
+	}
+
+
+	/**
+		@brief Add an element to the set
+
+		It adds a new element at the end of the set with the value in input.
+
+		@param val value of the new element
+		@throw duplicated_element_exception
+	*/
+	void add(const T& val)
+	{
+		if (!insert(val))
+			throw duplicated_element_exception();
+	}
+
+
+	/**
+		@brief Add an element to the set, moving its value
+
+		@param val value of the new element
+		@throw duplicated_element_exception
+	*/
+	void add(T&& val)
+	{
+		if (!insert(std::move(val)))
+			throw duplicated_element_exception();
+	}
+
+
+	/**
+		@brief Add an element to the set, if it is not there yet
+
+		@param val value of the new element
+		@return true if the element has been added, false if it was already in the set
+	*/
+	bool try_add(const T& val)
+	{
+		return insert(val);
+	}
+
+
+	/**
+		@brief Add an element to the set moving its value, if it is not there yet
+
+		@param val value of the new element
+		@return true if the element has been added, false if it was already in the set
+	*/
+	bool try_add(T&& val)
+	{
+		return insert(std::move(val));
+	}
+
+
+	/**
+		@brief Build an element and add it to the set
+
+		@tparam Args the types of the arguments
+		@param args the arguments passed to a constructor of T
+		@throw duplicated_element_exception
+	*/
+	template <typename... Args>
+	void emplace(Args&&... args)
+	{
+		add(T(std::forward<Args>(args)...));
+	}
+
+
+	/**
+		@brief Delete an element from the set
+
+		It removes from the set the element whose value corresponds to the
+		value toDelete in input. The following elements are shifted back,
+		so the insertion order is kept.
+
+		@param toDelete value of the element that has to be deleted
+		@throw non_existent_element_exception
+	*/
+	void remove(const T& toDelete)
+	{
+		if (!try_remove(toDelete))
+			throw non_existent_element_exception();
+	}
+
+
+	/**
+		@brief Delete an element from the set, if it is there
+
+		@param toDelete value of the element that has to be deleted
+		@return true if the element has been removed, false if it was not in the set
+	*/
+	bool try_remove(const T& toDelete)
+	{
+		std::size_t i = position(toDelete);
+		if (i == npos)
+			return false;
+		if (_spilled)
+			_heap.erase(_heap.begin() + i);
+		else
+		{
+			for (; i + 1 < _size; ++i)
+				*inlineAt(i) = std::move(*inlineAt(i + 1));
+			inlineAt(_size - 1)->~T();
+		}
+		--_size;
+		return true;
+	}
+
+
+	/**
+		@brief Get the element at a position
+
+		@param i the position of the element
+		@return the element at position i
+	*/
+	const T& operator[](unsigned int i) const
+	{
+		assert(i < _size);
+		return data()[i];
+	}
+
+
+	/**
+		@brief Get the number of elements in the set
+
+		@return the size of the set
+	*/
+	unsigned int size() const
+	{
+		return static_cast<unsigned int>(_size);
+	}
+
+
+	/**
+		@brief Check whether the elements are still inside the set
+
+		@return true if and only if the elements have not spilled to the heap
+	*/
+	bool is_inline() const
+	{
+		return !_spilled;
+	}
+
+
+	/**
+		@brief Check whether a value is in the set
+
+		@param value the value to look for
+		@return true if and only if an element equal to value is in the set
+	*/
+	bool contains(const T& value) const
+	{
+		return position(value) != npos;
+	}
+
+
+	/**
+		@brief Find a value in the set
+
+		@param value the value to look for
+		@return const_iterator to the element, or end() if there is none
+	*/
+	const_iterator find(const T& value) const
+	{
+		std::size_t i = position(value);
+		return i == npos ? end() : begin() + i;
+	}
+
+
+	/**
+		@brief Count the elements equal to a value
+
+		@param value the value to look for
+		@return the number of elements equal to value, either 0 or 1
+	*/
+	unsigned int count(const T& value) const
+	{
+		return contains(value) ? 1 : 0;
+	}
+
+
+	/**
+		@brief Swap the content of two sets
+
+		@param other the set whose elements are exchanged with the current set
+	*/
+	void swap(small_set& other)
+	{
+		small_set tmp(std::move(other));
+		other.take(*this);
+		take(tmp);
+	}
+
+
+	/**
+		@brief Get the const_iterator at the beginning of the data sequence
+
+		@return const_iterator at the beginning of the data sequence
+	*/
+	const_iterator begin() const
+	{
+		return data();
+	}
+
+
+	/**
+		@brief Get the const_iterator at the end of the data sequence
+
+		@return const_iterator at the end of the data sequence
+	*/
+	const_iterator end() const
+	{
+		return data() + _size;
+	}
+
+};
+
+/**
+	@brief Stream operator <<
+
+	Overriding of operator<< to write the elements of a small_set on a stream.
+
+	@tparam T the type of elements stored in the set setToPrint
+	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam N the number of elements stored inside the set
+	@param os output stream on which an element is sent
+	@param setToPrint the set to be sent on the output stream
+	@return the reference of the output stream
+*/
+template<typename T, typename Eql, std::size_t N>
+std::ostream &operator<<(std::ostream &os, const small_set<T, Eql, N> &setToPrint)
+{
+	typename small_set<T, Eql, N>::const_iterator ib, ie;
+	for (ib = setToPrint.begin(), ie = setToPrint.end(); ib!=ie; ++ib)
+	{
+		os << *ib << '\n';
+	}
+	return os;
+}
+
+
+/**
+	@brief Filter out the elements of a small_set
+
+	This function creates and returns a new set, whose elements come from
+	a set in input that do NOT satisfy a certain predicate.
+
+	@tparam T the type of elements stored in the set s
+	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam N the number of elements stored inside the set
+	@tparam Pred the predicate that musn't be satisfied
+	@param s the set whose elements will be analyzed and saved if they do NOT satisfy the predicate Pred
+	@return a new set containing the elements of s filtered out
+*/
+template<typename T, typename Eql, std::size_t N, typename Pred>
+small_set<T, Eql, N> filter_out(const small_set<T, Eql, N> &s, Pred pred)
+{
+	return (s | filtered_out(pred)).materialize();
+}
+
+
+/**
+	@brief Create a new small_set with the elements of two other sets
+
+	This function creates and returns a new set, whose elements come from
+	the union of two sets in input.
+
+	@tparam T the type of elements stored in the sets
+	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam N the number of elements stored inside the set
+	@param s1 the first set
+	@param s2 the second set
+	@return a new set of elements of s1 and s2
+	@throw duplicated_element_exception if an element appears more than once in the sets
+*/
+template<typename T, typename Eql, std::size_t N>
+small_set<T, Eql, N> operator+(const small_set<T, Eql, N> &s1, const small_set<T, Eql, N> &s2)
+{
+	small_set<T, Eql, N> resultSet(s1);
+	typename small_set<T, Eql, N>::const_iterator ib, ie;
+	for (ib = s2.begin(), ie = s2.end(); ib != ie; ++ib)
+		resultSet.add(*ib);
+	return resultSet;
+}
+
+
+/**
+	@brief Create a new small_set with the elements of two other sets, skipping duplicates
+
+	It is operator+ in insert_or_ignore mode.
+
+	@tparam T the type of elements stored in the sets
+	@tparam Eql functor used to check whether two elements are equal or not
+	@tparam N the number of elements stored inside the set
+	@param s1 the first set
+	@param s2 the second set
+	@return a new set of elements of s1 and s2, each one once
+*/
+template<typename T, typename Eql, std::size_t N>
+small_set<T, Eql, N> plus(const small_set<T, Eql, N> &s1, const small_set<T, Eql, N> &s2, insert_or_ignore_t)
+{
+	small_set<T, Eql, N> resultSet(s1);
+	typename small_set<T, Eql, N>::const_iterator ib, ie;
+	for (ib = s2.begin(), ie = s2.end(); ib != ie; ++ib)
+		resultSet.try_add(*ib);
+	return resultSet;
+}
+
+#endif
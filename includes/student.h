@@ -51,6 +51,16 @@ struct student
 	*/
 	student(const student& other);
 
+	/**
+		@brief Move constructor
+
+		It is used to create a student taking the name of another
+		student passed in input, without copying it.
+
+		@param other the other student to move
+	*/
+	student(student&& other) noexcept;
+
 	/**
 		@brief Assignment operator
 		
@@ -60,6 +70,15 @@ struct student
 	*/
 	student& operator=(const student& other);
 
+	/**
+		@brief Move assignment operator
+		
+		A student is assigned to another student, whose name is moved.
+
+		@param other the student to move
+	*/
+	student& operator=(student&& other) noexcept;
+
 	/**
 		@brief Destructor
 	*/
@@ -84,6 +103,6 @@ struct student
 	@param st the student to be sent to the output stream
 	@return a reference to the output stream passed in input
 */
-std::ostream &operator<<(std::ostream &os, const student st);
+std::ostream &operator<<(std::ostream &os, const student &st);
 
 #endif
@@ -1,10 +1,30 @@
 #include "set.h"
+#include "flat_set.h"
+#include "ordered_set.h"
+#include "parallel_filter.h"
+#include "small_set.h"
+#include "concurrent_set.h"
+#include "cow_set.h"
+#include "bloom_set.h"
+#include "serialization.h"
+#include "mapped_set.h"
+#include "bulk_writer.h"
 #include <string>
 #include <iostream>
 #include <list>
+#include <vector>
+#include <functional>
+#include <memory_resource>
+#include <thread>
+#include <atomic>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <type_traits>
 #include "duplicated_element_exception.h"
 #include "non_existent_element_exception.h"
 #include "student.h"
+#include "invalid_image_exception.h"
 
 // == FUNCTORS USED FOR TESTING ==
 
@@ -21,6 +41,11 @@ struct equal_int
 	}
 };
 
+/// equal_int is the built-in equality of int, so flat sets scan integers with vector instructions
+template <>
+struct is_builtin_equality<equal_int, int> : std::true_type
+{};
+
 
 /**
 	@brief A functor for testing
@@ -49,6 +74,78 @@ struct equal_student
 };
 
 
+/**
+	@brief A hash functor for testing
+
+	It returns the hash of an integer.
+*/
+struct hash_int 
+{
+	std::size_t operator()(int a) const 
+	{
+		return static_cast<std::size_t>(a);
+	}
+};
+
+/**
+	@brief A hash functor for testing
+
+	It returns the hash of a std::string.
+*/
+struct hash_string 
+{
+	std::size_t operator()(const std::string &a) const 
+	{
+		return std::hash<std::string>()(a);
+	}
+};
+
+/**
+	@brief A hash functor for testing
+
+	It returns the hash of a student, combining its name and age.
+*/
+struct hash_student 
+{
+	std::size_t operator()(const student &a) const 
+	{
+		return std::hash<std::string>()(a.name) * 31 + a.age;
+	}
+};
+
+/**
+	@brief A comparison functor for testing
+
+	It orders students by age, then by name.
+*/
+struct student_less 
+{
+	bool operator()(const student &a, const student &b) const 
+	{
+		return a.age < b.age || (a.age == b.age && a.name < b.name);
+	}
+};
+
+/**
+	@brief A comparison functor with a state, for testing
+
+	It orders integers in ascending or descending order, as chosen
+	when it is created.
+*/
+struct directed_less 
+{
+	bool descending;
+
+	explicit directed_less(bool d = false) : descending(d) 
+	{}
+
+	bool operator()(int a, int b) const 
+	{
+		return descending ? b < a : a < b;
+	}
+};
+
+
 // == PREDICATES USED FOR TESTING ==
 
 /**
@@ -108,6 +205,14 @@ struct is_odd
 typedef set<int, equal_int> set_int_type;
 typedef set<std::string, equal_string> set_string_type;
 typedef set<student, equal_student> set_student_type;
+typedef set<int, equal_int, hash_int> hashed_set_int_type;
+typedef set<std::string, equal_string, hash_string> hashed_set_string_type;
+typedef set<student, equal_student, hash_student> hashed_set_student_type;
+typedef flat_set<int, equal_int> flat_set_int_type;
+typedef flat_set<int, equal_int, hash_int> hashed_flat_set_int_type;
+typedef flat_set<student, equal_student, hash_student> hashed_flat_set_student_type;
+typedef ordered_set<int> ordered_set_int_type;
+typedef ordered_set<student, student_less> ordered_set_student_type;
 
 
 // == TEST FUNCTIONS ==
@@ -774,6 +879,1834 @@ void testStreamOperatorStudentType()
 	std::cout << "== END test stream operator<< students ==" << std::endl;
 }
 
+void testHashedSetWithIntegers() 
+{
+	hashed_set_int_type firstSet;
+	assert(0 == firstSet.size());
+
+	// test add, enough to grow the index several times
+	try 
+	{
+		for (int i = 0; i < 1000; ++i)
+			firstSet.add(i * 7);
+	}
+	catch(const duplicated_element_exception &e) 
+	{
+		assert(false); // there shouldn't be any exception thrown
+	}
+	assert(1000 == firstSet.size());
+	assert(0 == firstSet[0]);
+	assert(7 == firstSet[1]);
+	assert(6993 == firstSet[999]);
+
+	// test add with exceptions
+	try 
+	{
+		firstSet.add(6993);
+		assert(false); //an exception should be thrown
+	}
+	catch(const duplicated_element_exception &e) 
+	{
+		assert(1000 == firstSet.size());
+	}
+
+	// test remove of the first, a middle and the last element
+	try 
+	{
+		firstSet.remove(0);
+		firstSet.remove(70);
+		firstSet.remove(6993);
+		firstSet.add(0);
+	}
+	catch (...) 
+	{
+		assert(false); //no exceptions should be thrown
+	}
+	assert(998 == firstSet.size());
+	assert(7 == firstSet[0]);
+	assert(63 == firstSet[8]);
+	assert(77 == firstSet[9]);
+	assert(6986 == firstSet[996]);
+	assert(0 == firstSet[997]);
+
+	// test remove with exceptions
+	try 
+	{
+		firstSet.remove(70);
+		assert(false); //an exception should be thrown
+	}
+	catch(const non_existent_element_exception &e) 
+	{
+		assert(998 == firstSet.size());
+	}
+
+	// test copy constructor and assignment
+	hashed_set_int_type secondSet(firstSet);
+	assert(998 == secondSet.size());
+	secondSet.remove(7);
+	secondSet.add(70);
+	firstSet = secondSet;
+	assert(998 == firstSet.size());
+	assert(14 == firstSet[0]);
+	assert(70 == firstSet[997]);
+
+	// test filter_out and operator+
+	hashed_set_int_type odds = filter_out(firstSet, is_even());
+	hashed_set_int_type evens = filter_out(firstSet, is_odd());
+	assert(998 == odds.size() + evens.size());
+	hashed_set_int_type all = odds + evens;
+	assert(998 == all.size());
+	try 
+	{
+		all = all + odds;
+		assert(false); //an exception should be thrown
+	}
+	catch(const duplicated_element_exception &e) 
+	{
+		assert(998 == all.size());
+	}
+}
+
+void testHashedSetWithStudentType() 
+{
+	hashed_set_student_type firstSet;
+	try 
+	{
+		firstSet.add(student(21, "Simone"));
+		firstSet.add(student(20, "Francesco"));
+		firstSet.add(student(21, "Francesco"));
+	} 
+	catch(const duplicated_element_exception &e) 
+	{
+		assert(false); // there shouldn't be any exception thrown
+	}
+	assert(3 == firstSet.size());
+	assert(student(21, "Francesco") == firstSet[2]);
+
+	try 
+	{
+		firstSet.add(student(20, "Francesco"));
+		assert(false); //an exception should be thrown
+	}
+	catch(const duplicated_element_exception &e) 
+	{
+		assert(3 == firstSet.size());
+	}
+
+	firstSet.remove(student(20, "Francesco"));
+	assert(2 == firstSet.size());
+	assert(student(21, "Simone") == firstSet[0]);
+	assert(student(21, "Francesco") == firstSet[1]);
+
+	std::list<std::string> names;
+	names.push_back("Luca");
+	names.push_back("Marco");
+	hashed_set_string_type nameSet(names.begin(), names.end());
+	assert(2 == nameSet.size());
+	assert("Marco" == nameSet[1]);
+}
+
+void testMembership() 
+{
+	set_int_type mySet;
+	hashed_set_int_type myHashedSet;
+	for (int i = 0; i < 100; i += 2) 
+	{
+		mySet.add(i);
+		myHashedSet.add(i);
+	}
+
+	assert(mySet.contains(0));
+	assert(mySet.contains(98));
+	assert(!mySet.contains(7));
+	assert(1 == mySet.count(42));
+	assert(0 == mySet.count(43));
+	assert(42 == *mySet.find(42));
+	assert(mySet.end() == mySet.find(43));
+
+	assert(myHashedSet.contains(0));
+	assert(myHashedSet.contains(98));
+	assert(!myHashedSet.contains(7));
+	assert(1 == myHashedSet.count(42));
+	assert(0 == myHashedSet.count(43));
+	assert(42 == *myHashedSet.find(42));
+	assert(myHashedSet.end() == myHashedSet.find(43));
+
+	// the iterator returned by find continues in insertion order
+	set_int_type::const_iterator it = mySet.find(96);
+	++it;
+	assert(98 == *it);
+	hashed_set_int_type::const_iterator hit = myHashedSet.find(96);
+	++hit;
+	assert(98 == *hit);
+	++hit;
+	assert(myHashedSet.end() == hit);
+
+	myHashedSet.remove(42);
+	assert(!myHashedSet.contains(42));
+	assert(myHashedSet.end() == myHashedSet.find(42));
+
+	set_string_type stringSet;
+	stringSet.add("Simone");
+	assert(stringSet.contains("Simone"));
+	assert(!stringSet.contains("Carlo"));
+}
+
+void testHugeSet() 
+{
+	// every traversal must run in constant stack space: a recursive one
+	// would overflow the stack long before ten million elements
+	const int hugeSize = 10000000;
+	{
+		hashed_set_int_type hugeSet;
+		for (int i = 0; i < hugeSize; ++i)
+			hugeSet.add(i);
+		assert(static_cast<unsigned int>(hugeSize) == hugeSet.size());
+		assert(hugeSize - 1 == hugeSet[hugeSize - 1]);
+
+		hugeSet.remove(hugeSize - 1);
+		assert(hugeSize - 2 == hugeSet[hugeSize - 2]);
+
+		hashed_set_int_type copySet(hugeSet);
+		assert(hugeSet.size() == copySet.size());
+	} // both sets are destroyed here
+
+	// the scan of a set without index is iterative too
+	set_int_type longSet;
+	for (int i = 0; i < 20000; ++i)
+		longSet.add(i);
+	try 
+	{
+		longSet.add(19999);
+		assert(false); //an exception should be thrown
+	}
+	catch(const duplicated_element_exception &e) 
+	{
+		assert(20000 == longSet.size());
+	}
+	longSet.remove(19999);
+	assert(19998 == longSet[19998]);
+}
+
+void testAllocators() 
+{
+	// a pooled set reuses the nodes freed by remove
+	{
+		pooled_set<int, equal_int, hash_int> pooledSet;
+		for (int i = 0; i < 1000; ++i)
+			pooledSet.add(i);
+		const node_pool &pool = pooledSet.get_allocator().pool();
+		assert(1000 == pool.nodes_in_use());
+		std::size_t reserved = pool.nodes_reserved();
+
+		for (int i = 0; i < 500; ++i)
+			pooledSet.remove(i);
+		assert(500 == pool.nodes_in_use());
+		for (int i = 1000; i < 1500; ++i)
+			pooledSet.add(i);
+		assert(1000 == pooledSet.size());
+		assert(reserved == pool.nodes_reserved());
+		assert(500 == pooledSet[0]);
+		assert(1499 == pooledSet[999]);
+
+		// a copy takes its nodes from a new pool
+		pooled_set<int, equal_int, hash_int> copySet(pooledSet);
+		assert(copySet.get_allocator() != pooledSet.get_allocator());
+		assert(1000 == copySet.get_allocator().pool().nodes_in_use());
+
+		copySet = filter_out(pooledSet, is_even());
+		assert(500 == copySet.size());
+	}
+
+	// the buckets never fix the size of the pool, so no node is left outside to leak at the bulk release
+	{
+		int first[] = {0};
+		pooled_set<int, equal_int, hash_int> pooledSet(first, first + 1);
+		pooledSet.reserve(1);
+		for (int i = 1; i <= 100; ++i)
+			pooledSet.add(i);
+		const node_pool &pool = pooledSet.get_allocator().pool();
+		assert(101 == pool.nodes_in_use());
+		assert(1 == pool.blocks_outside()); // the buckets
+
+		pooled_set<int, equal_int, hash_int> smallSet(first, first + 1);
+		pooled_set<int, equal_int, hash_int> copySet(smallSet);
+		for (int i = 1; i <= 100; ++i)
+			copySet.add(i);
+		assert(101 == copySet.get_allocator().pool().nodes_in_use());
+
+		// a release is refused while a block taken outside the pool is alive
+		node_pool_allocator<int> alloc;
+		int* array = alloc.allocate(4);
+		int* node = alloc.allocate(1);
+		assert(1 == alloc.pool().blocks_outside());
+		assert(!alloc.release());
+		alloc.deallocate(array, 4);
+		assert(0 == alloc.pool().blocks_outside());
+		assert(alloc.release());
+		(void)node;
+	}
+
+	// pooled sets of non trivial types are destroyed element by element
+	{
+		pooled_set<std::string, equal_string> pooledSet;
+		pooledSet.add("Simone");
+		pooledSet.add("Carlo");
+		pooledSet.remove("Simone");
+		pooledSet.add("Paolo");
+		assert("Carlo" == pooledSet[0]);
+		assert("Paolo" == pooledSet[1]);
+	}
+
+	// a pmr set takes all its storage from the given memory resource
+	{
+		char buffer[4096];
+		std::pmr::monotonic_buffer_resource resource(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+		pmr_set<int, equal_int, hash_int> pmrSet(&resource);
+		for (int i = 0; i < 20; ++i)
+			pmrSet.add(i);
+		assert(20 == pmrSet.size());
+		assert(pmrSet.get_allocator().resource() == &resource);
+
+		pmr_set<int, equal_int, hash_int> otherSet(&resource);
+		otherSet.add(42);
+		otherSet = pmrSet;
+		assert(20 == otherSet.size());
+		assert(otherSet.get_allocator().resource() == &resource);
+	}
+}
+
+/**
+	Checks that a flat set of integers behaves like a set, except that
+	remove moves the last element into the hole.
+*/
+template <typename FlatSet>
+void testFlatSetWithIntegers() 
+{
+	FlatSet firstSet;
+	assert(0 == firstSet.size());
+
+	try 
+	{
+		for (int i = 0; i < 1000; ++i)
+			firstSet.add(i * 3);
+	}
+	catch(const duplicated_element_exception &e) 
+	{
+		assert(false); // there shouldn't be any exception thrown
+	}
+	assert(1000 == firstSet.size());
+	assert(0 == firstSet[0]);
+	assert(2997 == firstSet[999]);
+	assert(firstSet.contains(300));
+	assert(!firstSet.contains(301));
+	assert(100 == firstSet.find(300) - firstSet.begin());
+
+	try 
+	{
+		firstSet.add(300);
+		assert(false); //an exception should be thrown
+	}
+	catch(const duplicated_element_exception &e) 
+	{
+		assert(1000 == firstSet.size());
+	}
+
+	// the last element takes the position of the removed one
+	firstSet.remove(300);
+	assert(999 == firstSet.size());
+	assert(2997 == firstSet[100]);
+	assert(2994 == firstSet[998]);
+	assert(!firstSet.contains(300));
+	assert(firstSet.contains(2997));
+
+	firstSet.remove(2994);
+	assert(998 == firstSet.size());
+	assert(firstSet.contains(2991));
+	for (int i = 0; i < 500; ++i)
+		if (i * 6 != 300 && i * 6 != 2994)
+			firstSet.remove(i * 6);
+	assert(500 == firstSet.size());
+	for (int i = 0; i < 1000; ++i)
+		assert(firstSet.contains(i * 3) == (i % 2 == 1));
+
+	try 
+	{
+		firstSet.remove(300);
+		assert(false); //an exception should be thrown
+	}
+	catch(const non_existent_element_exception &e) 
+	{
+		assert(500 == firstSet.size());
+	}
+
+	FlatSet secondSet(firstSet);
+	secondSet.add(0);
+	firstSet = secondSet;
+	assert(501 == firstSet.size());
+
+	FlatSet evens = filter_out(firstSet, is_odd());
+	FlatSet odds = filter_out(firstSet, is_even());
+	assert(501 == evens.size() + odds.size());
+	FlatSet all = evens + odds;
+	assert(501 == all.size());
+	try 
+	{
+		all = all + odds;
+		assert(false); //an exception should be thrown
+	}
+	catch(const duplicated_element_exception &e) 
+	{
+		assert(501 == all.size());
+	}
+}
+
+void testFlatSetWithStudentType() 
+{
+	std::list<student> listStudents;
+	listStudents.push_back(student(22, "Luca"));
+	listStudents.push_back(student(26, "Marco"));
+	listStudents.push_back(student(25, "Giovanni"));
+	hashed_flat_set_student_type mySet(listStudents.begin(), listStudents.end());
+	assert(3 == mySet.size());
+	assert(student(26, "Marco") == mySet[1]);
+
+	mySet.remove(student(22, "Luca"));
+	assert(student(25, "Giovanni") == mySet[0]);
+	assert(student(26, "Marco") == mySet[1]);
+
+	hashed_flat_set_student_type filteredSet = filter_out(mySet, over_18());
+	assert(0 == filteredSet.size());
+}
+
+void testMoveSemantics() 
+{
+	// moves never throw, so vectors of sets move them when they grow
+	static_assert(std::is_nothrow_move_constructible<hashed_set_student_type>::value, "set move constructor must be noexcept");
+	static_assert(std::is_nothrow_move_assignable<hashed_set_student_type>::value, "set move assignment must be noexcept");
+	static_assert(std::is_nothrow_move_constructible<pooled_set<int, equal_int, hash_int> >::value, "pooled_set move constructor must be noexcept");
+	static_assert(std::is_nothrow_move_assignable<pooled_set<int, equal_int, hash_int> >::value, "pooled_set move assignment must be noexcept");
+	static_assert(std::is_nothrow_move_constructible<pmr_set<int, equal_int, hash_int> >::value, "pmr_set move constructor must be noexcept");
+	{
+		std::vector<hashed_set_student_type> sets(1);
+		sets[0].add(student(21, "Simone"));
+		const student *first = &sets[0][0];
+		sets.resize(sets.capacity() + 1);
+		assert(first == &sets[0][0]);
+	}
+
+	// move constructor and move assignment take the elements over
+	hashed_set_student_type firstSet;
+	firstSet.add(student(21, "Simone"));
+	firstSet.emplace(20, "Francesco");
+	const student *address = &firstSet[1];
+
+	hashed_set_student_type secondSet(std::move(firstSet));
+	assert(0 == firstSet.size());
+	assert(2 == secondSet.size());
+	assert(address == &secondSet[1]);
+	assert(student(20, "Francesco") == secondSet[1]);
+
+	firstSet = std::move(secondSet);
+	assert(0 == secondSet.size());
+	assert(address == &firstSet[1]);
+	assert(firstSet.contains(student(21, "Simone")));
+
+	// the moved-from set can be used again
+	secondSet.add(student(13, "Carlo"));
+	assert(1 == secondSet.size());
+
+	// add and emplace of duplicates
+	student carlo(13, "Carlo");
+	try 
+	{
+		secondSet.add(std::move(carlo));
+		assert(false); //an exception should be thrown
+	}
+	catch(const duplicated_element_exception &e) 
+	{
+		assert("Carlo" == carlo.name); // a rejected value is not moved
+	}
+	try 
+	{
+		secondSet.emplace(13, "Carlo");
+		assert(false); //an exception should be thrown
+	}
+	catch(const duplicated_element_exception &e) 
+	{
+		assert(1 == secondSet.size());
+	}
+
+	// operator+ on temporaries relinks the elements instead of copying them
+	set_string_type names1, names2;
+	names1.add(std::string("Simone"));
+	names1.emplace("Giovanni");
+	names2.emplace(5, 'a');
+	const std::string *first = &names1[0];
+	const std::string *last = &names2[0];
+	set_string_type allNames = std::move(names1) + std::move(names2);
+	assert(3 == allNames.size());
+	assert(first == &allNames[0]);
+	assert(last == &allNames[2]);
+	assert("aaaaa" == allNames[2]);
+	assert(0 == names2.size());
+
+	set_string_type moreNames;
+	moreNames.add("Carlo");
+	set_string_type copyNames = allNames + std::move(moreNames);
+	assert(4 == copyNames.size());
+	assert("Carlo" == copyNames[3]);
+	assert(0 == moreNames.size());
+	try 
+	{
+		copyNames = set_string_type(copyNames) + copyNames;
+		assert(false); //an exception should be thrown
+	}
+	catch(const duplicated_element_exception &e) 
+	{
+		assert(4 == copyNames.size());
+	}
+
+	// the same holds for flat sets
+	hashed_flat_set_student_type flatSet;
+	flatSet.emplace(21, "Simone");
+	flatSet.add(student(20, "Francesco"));
+	try 
+	{
+		flatSet.emplace(21, "Simone");
+		assert(false); //an exception should be thrown
+	}
+	catch(const duplicated_element_exception &e) 
+	{
+		assert(2 == flatSet.size());
+	}
+	hashed_flat_set_student_type otherFlatSet(std::move(flatSet));
+	assert(2 == otherFlatSet.size());
+	otherFlatSet = std::move(otherFlatSet) + hashed_flat_set_student_type();
+	assert(otherFlatSet.contains(student(20, "Francesco")));
+}
+
+void testBulkConstruction() 
+{
+	std::vector<int> extract;
+	for (int i = 0; i < 500000; ++i)
+		extract.push_back(i * 13);
+
+	hashed_set_int_type mySet(extract.begin(), extract.end());
+	assert(500000 == mySet.size());
+	assert(0 == mySet[0]);
+	assert(13 * 499999 == mySet[499999]);
+	assert(mySet.contains(13 * 250000));
+
+	hashed_flat_set_int_type myFlatSet(extract.begin(), extract.end());
+	assert(500000 == myFlatSet.size());
+	assert(13 * 499999 == myFlatSet[499999]);
+	assert(myFlatSet.contains(13 * 250000));
+
+	// a duplicate in the range is still reported
+	extract.push_back(13);
+	try 
+	{
+		hashed_set_int_type otherSet(extract.begin(), extract.end());
+		assert(false); //an exception should be thrown
+	}
+	catch(const duplicated_element_exception &e) 
+	{
+		/* okay */
+	}
+
+	// reserve does not change the content of a set
+	hashed_set_int_type reservedSet;
+	reservedSet.add(1);
+	reservedSet.reserve(1000);
+	for (int i = 2; i < 1000; ++i)
+		reservedSet.add(i);
+	assert(999 == reservedSet.size());
+	assert(1 == reservedSet[0]);
+	assert(reservedSet.contains(500));
+	flat_set_int_type reservedFlatSet;
+	reservedFlatSet.reserve(10);
+	reservedFlatSet.add(3);
+	assert(reservedFlatSet.contains(3));
+}
+
+void testPositionalAccess() 
+{
+	// a full loop over a large set takes linear time
+	const int bigSize = 1000000;
+	hashed_set_int_type bigSet;
+	for (int i = 0; i < bigSize; ++i)
+		bigSet.add(i);
+	long long sum = 0;
+	for (unsigned int i = 0; i < bigSet.size(); ++i)
+		sum += bigSet[i];
+	assert(sum == static_cast<long long>(bigSize) * (bigSize - 1) / 2);
+	for (unsigned int i = bigSet.size(); i > 0; --i)
+		assert(static_cast<int>(i - 1) == bigSet[i - 1]);
+
+	// loops over two sets at once, also without hash index
+	set_int_type firstSet, secondSet;
+	for (int i = 0; i < 5000; ++i) 
+	{
+		firstSet.add(i);
+		secondSet.add(-i);
+	}
+	for (unsigned int i = 0; i < firstSet.size(); ++i)
+		assert(firstSet[i] == -secondSet[i]);
+
+	// the remembered positions follow the changes of the set
+	assert(2500 == firstSet[2500]);
+	firstSet.remove(0);
+	assert(2501 == firstSet[2500]);
+	firstSet.remove(2501);
+	assert(2502 == firstSet[2500]);
+	firstSet.add(-1);
+	assert(-1 == firstSet[firstSet.size() - 1]);
+
+	assert(500000 == bigSet[500000]);
+	bigSet.remove(10);
+	assert(500001 == bigSet[500000]);
+	hashed_set_int_type otherSet;
+	otherSet.add(42);
+	otherSet.swap(bigSet);
+	assert(42 == bigSet[0]);
+	assert(500001 == otherSet[500000]);
+
+	// flat sets have random access iterators
+	hashed_flat_set_int_type flatSet;
+	for (int i = 0; i < 100; ++i)
+		flatSet.add(i);
+	hashed_flat_set_int_type::const_iterator it = flatSet.begin() + 50;
+	assert(50 == *it);
+	assert(49 == it[-1]);
+	assert(100 == flatSet.end() - flatSet.begin());
+}
+
+void testOrderedSet() 
+{
+	ordered_set_int_type firstSet;
+	try 
+	{
+		firstSet.add(42);
+		firstSet.add(5);
+		firstSet.add(17);
+		firstSet.emplace(8);
+		firstSet.add(1);
+	}
+	catch(const duplicated_element_exception &e) 
+	{
+		assert(false); // there shouldn't be any exception thrown
+	}
+	assert(5 == firstSet.size());
+	assert(1 == firstSet[0]);
+	assert(5 == firstSet[1]);
+	assert(8 == firstSet[2]);
+	assert(17 == firstSet[3]);
+	assert(42 == firstSet[4]);
+
+	try 
+	{
+		firstSet.add(17);
+		assert(false); //an exception should be thrown
+	}
+	catch(const duplicated_element_exception &e) 
+	{
+		assert(5 == firstSet.size());
+	}
+	firstSet.remove(8);
+	assert(17 == firstSet[2]);
+	try 
+	{
+		firstSet.remove(8);
+		assert(false); //an exception should be thrown
+	}
+	catch(const non_existent_element_exception &e) 
+	{
+		assert(4 == firstSet.size());
+	}
+
+	// range queries
+	assert(5 == *firstSet.lower_bound(2));
+	assert(5 == *firstSet.lower_bound(5));
+	assert(17 == *firstSet.upper_bound(5));
+	assert(firstSet.end() == firstSet.upper_bound(42));
+	assert(2 == firstSet.upper_bound(20) - firstSet.lower_bound(5));
+	assert(firstSet.contains(42));
+	assert(!firstSet.contains(43));
+
+	// set algebra by linear merge
+	std::vector<int> values;
+	for (int i = 0; i < 20; ++i)
+		values.push_back(19 - i);
+	ordered_set_int_type upTo20(values.begin(), values.end());
+	assert(0 == upTo20[0]);
+	assert(19 == upTo20[19]);
+
+	ordered_set_int_type unionSet = set_union(firstSet, upTo20);
+	assert(21 == unionSet.size());
+	assert(42 == unionSet[20]);
+	ordered_set_int_type intersectionSet = set_intersection(firstSet, upTo20);
+	assert(3 == intersectionSet.size());
+	assert(1 == intersectionSet[0]);
+	assert(17 == intersectionSet[2]);
+	ordered_set_int_type differenceSet = set_difference(firstSet, upTo20);
+	assert(1 == differenceSet.size());
+	assert(42 == differenceSet[0]);
+
+	try 
+	{
+		ordered_set_int_type sumSet = firstSet + upTo20;
+		assert(false); //an exception should be thrown
+	}
+	catch(const duplicated_element_exception &e) 
+	{ 
+		/* okay */
+	}
+	ordered_set_int_type sumSet = differenceSet + upTo20;
+	assert(21 == sumSet.size());
+
+	ordered_set_int_type oddSet = filter_out(upTo20, is_even());
+	assert(10 == oddSet.size());
+	assert(1 == oddSet[0]);
+	assert(19 == oddSet[9]);
+
+	values.push_back(3);
+	try 
+	{
+		ordered_set_int_type otherSet(values.begin(), values.end());
+		assert(false); //an exception should be thrown
+	}
+	catch(const duplicated_element_exception &e) 
+	{
+		/* okay */
+	}
+
+	// students in order of age
+	ordered_set_student_type students;
+	students.add(student(21, "Simone"));
+	students.add(student(13, "Carlo"));
+	students.add(student(21, "Francesco"));
+	assert(student(13, "Carlo") == students[0]);
+	assert(student(21, "Francesco") == students[1]);
+	ordered_set_student_type adults = filter_out(students, std::not_fn(over_18()));
+	assert(2 == adults.size());
+	assert(students.lower_bound(student(18, "")) == students.begin() + 1);
+
+	// the comparison functor of the operands is kept by the results
+	int numbers[] = {5, 1, 3, 2};
+	ordered_set<int, directed_less> descending(numbers, numbers + 3, directed_less(true));
+	ordered_set<int, directed_less> others(numbers + 2, numbers + 4, insert_or_ignore, directed_less(true));
+	assert(5 == descending[0]);
+	assert(1 == descending[2]);
+	ordered_set<int, directed_less> merged = plus(descending, others, insert_or_ignore);
+	assert(4 == merged.size());
+	assert(5 == merged[0]);
+	assert(1 == merged[3]);
+	assert(merged.key_comp().descending);
+	ordered_set<int, directed_less> common = set_intersection(descending, others);
+	assert(1 == common.size());
+	assert(common.contains(3));
+	ordered_set<int, directed_less> odd = filter_out(merged, is_even());
+	assert(5 == odd[0]);
+	assert(odd.contains(1));
+	assert(odd.key_comp().descending);
+
+	// a swap exchanges the comparison functors along with the elements
+	int upTo7[] = {1, 2, 3, 4, 5, 6, 7};
+	ordered_set<int, directed_less> down(upTo7, upTo7 + 7, directed_less(true));
+	ordered_set<int, directed_less> up(upTo7, upTo7 + 3, directed_less(false));
+	down.swap(up);
+	assert(up.key_comp().descending && !down.key_comp().descending);
+	assert(7 == up[0] && 1 == up[6]);
+	assert(up.contains(5) && up.contains(1));
+	assert(down.contains(2) && !down.contains(5));
+
+	// a view of an ordered set keeps its comparison functor
+	ordered_set<int, directed_less> viewed = (up | filtered_out(is_even())).materialize();
+	assert(viewed.key_comp().descending);
+	assert(4 == viewed.size());
+	assert(7 == viewed[0] && 1 == viewed[3]);
+	assert(viewed.contains(5));
+
+	// so does the parallel filter, with one thread or many
+	for (unsigned int threads = 1; threads <= 4; threads += 3) 
+	{
+		ordered_set<int, directed_less> odd = filter_out(up, is_even(), parallel(threads));
+		assert(odd.key_comp().descending);
+		assert(7 == odd[0] && 1 == odd[3]);
+		assert(odd.contains(3));
+	}
+}
+
+
+template <typename Set>
+void testTryAddRemove() 
+{
+	Set s;
+	assert(s.try_add(3));
+	assert(s.try_add(5));
+	assert(!s.try_add(3));
+	int seven = 7;
+	assert(s.try_add(std::move(seven)));
+	assert(3 == s.size());
+	assert(!s.try_remove(4));
+	assert(s.try_remove(5));
+	assert(!s.try_remove(5));
+	assert(2 == s.size());
+	assert(s.contains(3));
+	assert(s.contains(7));
+
+	// the range constructor and plus keep the first occurrence of each value
+	int values[] = {4, 2, 4, 1, 2, 8};
+	Set fromRange(values, values + 6, insert_or_ignore);
+	assert(4 == fromRange.size());
+	Set other(values + 4, values + 6);
+	Set sum = plus(fromRange, other, insert_or_ignore);
+	assert(4 == sum.size());
+	sum = plus(sum, s, insert_or_ignore);
+	assert(6 == sum.size());
+	assert(sum.contains(7));
+}
+
+void testTryAddAllocatesNothing() 
+{
+	// a rejected element does not take a node from the pool
+	pooled_set<int, equal_int, hash_int> pooledSet;
+	for (int i = 0; i < 100; ++i)
+		assert(pooledSet.try_add(i));
+	const node_pool &pool = pooledSet.get_allocator().pool();
+	for (int i = 0; i < 100; ++i)
+		assert(!pooledSet.try_add(i));
+	assert(100 == pool.nodes_in_use());
+
+	// the unhashed set keeps the insertion order of the first occurrences
+	std::string names[] = {"Simone", "Carlo", "Simone", "Paolo", "Carlo"};
+	set_string_type nameSet(names, names + 5, insert_or_ignore);
+	assert(3 == nameSet.size());
+	assert("Simone" == nameSet[0]);
+	assert("Carlo" == nameSet[1]);
+	assert("Paolo" == nameSet[2]);
+	assert(!nameSet.try_remove("Francesco"));
+	assert(nameSet.try_remove("Paolo"));
+	assert(nameSet.try_add("Francesco"));
+	assert("Francesco" == nameSet[2]);
+}
+
+
+template <typename Set>
+void testSetAlgebra() 
+{
+	Set evens, lowSet;
+	for (int i = 0; i < 20; i += 2)
+		evens.add(i);
+	for (int i = 0; i < 5; ++i)
+		lowSet.add(i);
+
+	Set unionSet = set_union(evens, lowSet);
+	assert(12 == unionSet.size());
+	assert(unionSet.contains(3));
+	assert(unionSet.contains(18));
+	assert(12 == (evens | lowSet).size());
+
+	Set intersectionSet = evens & lowSet;
+	assert(3 == intersectionSet.size());
+	assert(intersectionSet.contains(0) && intersectionSet.contains(2) && intersectionSet.contains(4));
+
+	Set differenceSet = evens - lowSet;
+	assert(7 == differenceSet.size());
+	assert(!differenceSet.contains(4));
+	assert(differenceSet.contains(6));
+
+	Set symmetricSet = evens ^ lowSet;
+	assert(9 == symmetricSet.size());
+	assert(symmetricSet.contains(1) && symmetricSet.contains(3));
+	assert(!symmetricSet.contains(2));
+
+	Set emptySet;
+	assert(0 == (emptySet & evens).size());
+	assert(10 == (evens - emptySet).size());
+	assert(10 == (emptySet | evens).size());
+}
+
+void testHashedSetAlgebra() 
+{
+	// the order of the first operand comes first
+	hashed_set_string_type names, others;
+	names.add("Simone");
+	names.add("Carlo");
+	names.add("Paolo");
+	others.add("Paolo");
+	others.add("Francesco");
+	hashed_set_string_type unionSet = names | others;
+	assert(4 == unionSet.size());
+	assert("Simone" == unionSet[0]);
+	assert("Paolo" == unionSet[2]);
+	assert("Francesco" == unionSet[3]);
+	hashed_set_string_type symmetricSet = names ^ others;
+	assert("Simone" == symmetricSet[0]);
+	assert("Carlo" == symmetricSet[1]);
+	assert("Francesco" == symmetricSet[2]);
+
+	// large sets are combined in linear time
+	hashed_set_int_type bigSet, otherBigSet;
+	for (int i = 0; i < 200000; ++i) 
+	{
+		bigSet.add(i);
+		otherBigSet.add(i + 100000);
+	}
+	assert(300000 == (bigSet | otherBigSet).size());
+	assert(100000 == (bigSet & otherBigSet).size());
+	assert(100000 == (bigSet - otherBigSet).size());
+	assert(200000 == (bigSet ^ otherBigSet).size());
+}
+
+
+template <typename Set>
+void testFilterViews() 
+{
+	Set s;
+	for (int i = 0; i < 30; ++i)
+		s.add(i);
+
+	// views copy nothing and chain their predicates
+	auto oddView = s | filtered_out(is_even());
+	int count = 0;
+	for (auto it = oddView.begin(); it != oddView.end(); ++it) 
+	{
+		assert(*it % 2 != 0);
+		++count;
+	}
+	assert(15 == count);
+
+	auto view = s | filtered_out(is_even()) | filtered_out([](int a) { return a % 3 == 0; });
+	Set result = view.materialize();
+	assert(10 == result.size());
+	assert(result.contains(1));
+	assert(!result.contains(9));
+	assert(!result.contains(10));
+
+	// a view follows the changes of its set
+	s.remove(1);
+	assert(9 == Set(view.begin(), view.end(), assume_unique).size());
+	assert((s | filtered_out(is_odd()) | filtered_out(is_even())).empty());
+
+	// filter_out gives the materialized view
+	assert(15 == filter_out(s, is_odd()).size());
+}
+
+void testFilterViewWithStudentType() 
+{
+	hashed_set_student_type students;
+	students.add(student(21, "Simone"));
+	students.add(student(13, "Carlo"));
+	students.add(student(17, "Paolo"));
+	students.add(student(30, "Francesco"));
+	auto youngView = students | filtered_out(over_18()) | filtered_out([](const student& s) { return s.name == "Carlo"; });
+	assert("Paolo" == youngView.begin()->name);
+	hashed_set_student_type young = youngView.materialize();
+	assert(1 == young.size());
+	assert(young.contains(student(17, "Paolo")));
+
+	// a view can be copied into another kind of set
+	ordered_set_student_type inOrder = (students | filtered_out(std::not_fn(over_18()))).materialize<ordered_set_student_type>();
+	assert(2 == inOrder.size());
+	assert(student(21, "Simone") == inOrder[0]);
+}
+
+
+/**
+	Predicate failing on a given value, to test the parallel filter
+*/
+struct throws_on_500 
+{
+	bool operator()(int a) const 
+	{
+		if (a == 500)
+			throw non_existent_element_exception();
+		return false;
+	}
+};
+
+template <typename Set>
+void testParallelFilter() 
+{
+	Set s;
+	for (int i = 999; i >= 0; --i)
+		s.add(i);
+
+	// the survivors keep their order, whatever the number of threads
+	Set serial = filter_out(s, is_even());
+	for (unsigned int threads = 1; threads <= 8; ++threads) 
+	{
+		Set parallelSet = filter_out(s, is_even(), parallel(threads));
+		assert(500 == parallelSet.size());
+		for (unsigned int i = 0; i < 500; ++i)
+			assert(serial[i] == parallelSet[i]);
+	}
+	assert(500 == filter_out(s, is_odd(), parallel()).size());
+
+	// more threads than elements
+	Set small;
+	small.add(1);
+	small.add(2);
+	assert(1 == filter_out(small, is_even(), parallel(16)).size());
+	assert(0 == filter_out(Set(), is_even(), parallel(4)).size());
+
+	// an exception of the predicate reaches the caller
+	try 
+	{
+		filter_out(s, throws_on_500(), parallel(4));
+		assert(false); //an exception should be thrown
+	}
+	catch(const non_existent_element_exception &e) 
+	{
+		/* okay */
+	}
+}
+
+
+template <typename T>
+void testSimdFindOf() 
+{
+	// every position, near and across the borders of the registers
+	for (std::size_t n = 0; n < 70; ++n) 
+	{
+		std::vector<T> values;
+		for (std::size_t i = 0; i < n; ++i)
+			values.push_back(static_cast<T>(i + 1));
+		for (std::size_t i = 0; i < n; ++i)
+			assert(i == simd_find(values.data(), n, static_cast<T>(i + 1)));
+		assert(n == simd_find(values.data(), n, static_cast<T>(0)));
+	}
+}
+
+void testSimdScan() 
+{
+	testSimdFindOf<char>();
+	testSimdFindOf<short>();
+	testSimdFindOf<int>();
+	testSimdFindOf<long long>();
+	testSimdFindOf<unsigned int>();
+	testSimdFindOf<float>();
+	testSimdFindOf<double>();
+
+	// values with the same low bytes are told apart
+	long long big[] = {1LL << 40, (1LL << 40) + 1, 1};
+	assert(2 == simd_find(big, 3, 1LL));
+	double zeros[] = {1.5, -0.0};
+	assert(1 == simd_find(zeros, 2, 0.0));
+
+	// flat sets of integers use it for add, contains, remove and filter_out
+	flat_set_int_type ids;
+	for (int i = 0; i < 1000; ++i)
+		ids.add(i * 7);
+	assert(ids.contains(693));
+	assert(!ids.contains(694));
+	assert(!ids.try_add(700));
+	ids.emplace(1);
+	try 
+	{
+		ids.emplace(7);
+		assert(false); //an exception should be thrown
+	}
+	catch(const duplicated_element_exception &e) 
+	{
+		/* okay */
+	}
+	ids.remove(0);
+	assert(1000 == ids.size());
+	assert(!ids.contains(0));
+	assert(499 == filter_out(ids, is_odd()).size());
+
+	flat_set<double, std::equal_to<double> > doubles;
+	doubles.add(0.5);
+	doubles.add(-0.0);
+	assert(!doubles.try_add(0.0));
+	assert(doubles.contains(0.5));
+}
+
+
+void testCopies() 
+{
+	// copies of unhashed sets are linear, so large ones are cheap
+	std::vector<int> values;
+	for (int i = 0; i < 20000; ++i)
+		values.push_back(i);
+	hashed_set_int_type source(values.begin(), values.end());
+	set_int_type unhashedSource(source.begin(), source.end(), assume_unique);
+	set_int_type unhashedCopy(unhashedSource);
+	assert(20000 == unhashedCopy.size());
+	assert(19999 == unhashedCopy[19999]);
+
+	// assignment reuses the elements of trivially copyable sets
+	pooled_set<int, equal_int, hash_int> target;
+	for (int i = 0; i < 100; ++i)
+		target.add(-i);
+	const node_pool &pool = target.get_allocator().pool();
+	std::size_t reserved = pool.nodes_reserved();
+	pooled_set<int, equal_int, hash_int> smallSet, largeSet;
+	for (int i = 0; i < 10; ++i)
+		smallSet.add(i);
+	for (int i = 0; i < 150; ++i)
+		largeSet.add(i * 2);
+
+	target = smallSet;
+	assert(10 == target.size());
+	assert(10 == pool.nodes_in_use());
+	assert(reserved == pool.nodes_reserved());
+	assert(target.contains(9));
+	assert(!target.contains(-1));
+	assert(9 == target[9]);
+	target.add(42);
+	assert(42 == target[10]);
+
+	target = largeSet;
+	assert(150 == target.size());
+	assert(150 == pool.nodes_in_use());
+	assert(298 == target[149]);
+	assert(target.contains(200));
+	assert(!target.contains(9));
+	target.remove(298);
+	target.remove(0);
+	assert(2 == target[0]);
+
+	pooled_set<int, equal_int, hash_int> emptySet;
+	target = emptySet;
+	assert(0 == target.size());
+	assert(0 == pool.nodes_in_use());
+	target.add(1);
+	assert(target.contains(1));
+
+	// the same on unhashed sets
+	set_int_type unhashedTarget;
+	unhashedTarget.add(5);
+	unhashedTarget = unhashedCopy;
+	assert(20000 == unhashedTarget.size());
+	unhashedTarget = set_int_type();
+	assert(0 == unhashedTarget.size());
+	unhashedTarget.add(3);
+	assert(3 == unhashedTarget[0]);
+
+	// non trivial types are still copied and swapped
+	hashed_set_string_type names, others;
+	names.add("Simone");
+	others.add("Carlo");
+	others.add("Paolo");
+	names = others;
+	assert(2 == names.size());
+	assert("Paolo" == names[1]);
+}
+
+
+void testSmallSet() 
+{
+	// the elements stay inside the set until they overflow it
+	small_set<int, equal_int, 4> tags;
+	for (int i = 0; i < 4; ++i)
+		tags.add(i * 10);
+	assert(tags.is_inline());
+	assert(!tags.try_add(20));
+	assert(tags.contains(30));
+	tags.remove(10);
+	assert(20 == tags[1]);
+	tags.add(40);
+	tags.add(50);
+	assert(!tags.is_inline());
+	assert(5 == tags.size());
+	assert(0 == tags[0]);
+	assert(50 == tags[4]);
+	assert(tags.end() == tags.find(10));
+	assert(3 == filter_out(tags, [](int a) { return a > 30; }).size());
+
+	// moves never throw, so vectors of sets move them when they grow
+	static_assert(std::is_nothrow_move_constructible<small_set<int, equal_int, 4> >::value, "small_set move constructor must be noexcept");
+	static_assert(std::is_nothrow_move_assignable<small_set<int, equal_int, 4> >::value, "small_set move assignment must be noexcept");
+	static_assert(std::is_nothrow_move_constructible<small_set<std::string, equal_string> >::value, "small_set move constructor must be noexcept");
+
+	// copies and moves between inline and spilled sets
+	small_set<std::string, equal_string> names, others;
+	names.add("Simone");
+	names.add("Carlo");
+	for (int i = 0; i < 20; ++i)
+		others.add(std::to_string(i));
+	assert(names.is_inline());
+	assert(!others.is_inline());
+
+	small_set<std::string, equal_string> copyNames(names), copyOthers(others);
+	assert(copyNames.is_inline());
+	assert(20 == copyOthers.size());
+	assert("19" == copyOthers[19]);
+	copyNames.swap(copyOthers);
+	assert(20 == copyNames.size());
+	assert("Carlo" == copyOthers[1]);
+	small_set<std::string, equal_string> movedNames(std::move(copyOthers));
+	assert(0 == copyOthers.size());
+	assert("Simone" == movedNames[0]);
+	copyOthers = names;
+	copyOthers.add("Paolo");
+	assert(3 == copyOthers.size());
+	copyOthers = std::move(copyNames);
+	assert(20 == copyOthers.size());
+	copyOthers.remove("0");
+	assert("1" == copyOthers[0]);
+
+	small_set<std::string, equal_string> sum = plus(names, copyOthers, insert_or_ignore);
+	assert(21 == sum.size());
+	try 
+	{
+		sum = names + names;
+		assert(false); //an exception should be thrown
+	}
+	catch(const duplicated_element_exception &e) 
+	{
+		/* okay */
+	}
+}
+
+
+void testConcurrentSet() 
+{
+	typedef concurrent_set<int, equal_int, hash_int> concurrent_int_set;
+	concurrent_int_set shared;
+	shared.add(1);
+	assert(!shared.try_add(1));
+	assert(shared.contains(1));
+	try 
+	{
+		shared.remove(2);
+		assert(false); //an exception should be thrown
+	}
+	catch(const non_existent_element_exception &e) 
+	{
+		/* okay */
+	}
+	shared.remove(1);
+	assert(0 == shared.size());
+
+	// the threads add overlapping ranges: each value is added exactly once
+	const int threads = 8;
+	const int perThread = 20000;
+	std::atomic<int> added(0);
+	std::atomic<int> removed(0);
+	std::atomic<bool> inconsistent(false);
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; ++t) 
+	{
+		workers.push_back(std::thread([&shared, &added, &inconsistent, t, perThread]() 
+		{
+			int first = t * perThread / 2;
+			for (int i = first; i < first + perThread; ++i) 
+			{
+				if (shared.try_add(i))
+					++added;
+				if (!shared.contains(i))
+					inconsistent = true;
+			}
+		}));
+	}
+
+	// snapshots are taken while the workers run
+	for (int i = 0; i < 20; ++i) 
+	{
+		hashed_set_int_type copy = shared.snapshot();
+		for (unsigned int j = 0; j < copy.size(); j += 97)
+			assert(copy.contains(copy[j]));
+	}
+	for (std::size_t t = 0; t < workers.size(); ++t)
+		workers[t].join();
+
+	// the odd values are removed by whoever gets them first
+	workers.clear();
+	for (int t = 0; t < threads; ++t) 
+	{
+		workers.push_back(std::thread([&shared, &removed, t, perThread]() 
+		{
+			int first = t * perThread / 2;
+			for (int i = first + 1; i < first + perThread; i += 2)
+				if (shared.try_remove(i))
+					++removed;
+		}));
+	}
+	for (std::size_t t = 0; t < workers.size(); ++t)
+		workers[t].join();
+
+	const int distinct = (threads + 1) * perThread / 2;
+	assert(!inconsistent);
+	assert(distinct == added);
+	assert(distinct / 2 == removed);
+	assert(static_cast<unsigned int>(distinct / 2) == shared.size());
+	hashed_set_int_type copy = shared.snapshot();
+	assert(shared.size() == copy.size());
+	assert(copy.contains(0));
+	assert(!copy.contains(1));
+	shared.clear();
+	assert(0 == shared.size());
+}
+
+
+void testCopyOnWrite() 
+{
+	typedef cow_set<hashed_set_int_type> cow_int_set;
+	cow_int_set original;
+	assert(0 == original.size());
+	for (int i = 0; i < 1000; ++i)
+		original.add(i);
+	assert(!original.is_shared());
+
+	// copies share the elements until one of them is changed
+	cow_int_set copy(original);
+	cow_int_set other;
+	other = copy;
+	assert(original.is_shared());
+	assert(&original.get() == &copy.get());
+	assert(!copy.try_add(5));
+	assert(!copy.try_remove(1000));
+	assert(&original.get() == &copy.get());
+	try 
+	{
+		copy.add(5);
+		assert(false); //an exception should be thrown
+	}
+	catch(const duplicated_element_exception &e) 
+	{
+		assert(&original.get() == &copy.get());
+	}
+
+	copy.remove(0);
+	assert(&original.get() != &copy.get());
+	assert(999 == copy.size());
+	assert(1000 == original.size());
+	assert(original.contains(0));
+	assert(1 == copy[0]);
+	other.add(1000);
+	assert(!original.is_shared());
+	assert(1001 == other.size());
+
+	// copies handed to other threads are read and changed there
+	std::vector<std::thread> workers;
+	std::atomic<int> found(0);
+	for (int t = 0; t < 4; ++t) 
+	{
+		workers.push_back(std::thread([original, t, &found]() mutable 
+		{
+			for (int i = 0; i < 1000; ++i)
+				found += original.count(i);
+			original.add(1000 + t);
+			assert(1001 == original.size());
+		}));
+	}
+	for (std::size_t t = 0; t < workers.size(); ++t)
+		workers[t].join();
+	assert(4000 == found);
+	assert(1000 == original.size());
+	assert(!original.is_shared());
+
+	cow_set<set_string_type> names;
+	names.emplace("Simone");
+	cow_set<set_string_type> moreNames(names);
+	moreNames.add("Carlo");
+	assert(1 == names.size());
+	cow_set<set_string_type> sixLetters = filter_out(moreNames, hasnt_six_characters());
+	assert(1 == sixLetters.size());
+	assert("Simone" == sixLetters[0]);
+	cow_set<set_string_type> others;
+	others.add("Paolo");
+	assert(2 == (names + others).size());
+}
+
+
+void testSerialization() 
+{
+	// images can be read back by every kind of set
+	hashed_set_int_type numbers;
+	for (int i = 0; i < 1000; ++i)
+		numbers.add(i * 3);
+	std::stringstream image(std::ios::in | std::ios::out | std::ios::binary);
+	serialize(image, numbers);
+	hashed_set_int_type numbersCopy = deserialize<hashed_set_int_type>(image);
+	assert(1000 == numbersCopy.size());
+	assert(2997 == numbersCopy[999]);
+	assert(numbersCopy.contains(300));
+	image.seekg(0);
+	ordered_set_int_type orderedCopy = deserialize<ordered_set_int_type>(image);
+	assert(1000 == orderedCopy.size());
+
+	set_string_type names;
+	names.add("Simone");
+	names.add("");
+	names.add("Carlo");
+	std::stringstream namesImage(std::ios::in | std::ios::out | std::ios::binary);
+	serialize(namesImage, names);
+	set_string_type namesCopy = deserialize<set_string_type>(namesImage);
+	assert(3 == namesCopy.size());
+	assert("" == namesCopy[1]);
+	assert("Carlo" == namesCopy[2]);
+
+	hashed_set_student_type students;
+	students.add(student(21, "Simone"));
+	students.add(student(13, "Carlo"));
+	std::stringstream studentsImage(std::ios::in | std::ios::out | std::ios::binary);
+	serialize(studentsImage, students);
+	hashed_set_student_type studentsCopy = deserialize<hashed_set_student_type>(studentsImage);
+	assert(2 == studentsCopy.size());
+	assert(studentsCopy.contains(student(13, "Carlo")));
+
+	// images of another type, damaged or truncated are refused
+	try 
+	{
+		namesImage.seekg(0);
+		deserialize<hashed_set_int_type>(namesImage);
+		assert(false); //an exception should be thrown
+	}
+	catch(const invalid_image_exception &e) 
+	{
+		/* okay */
+	}
+	try 
+	{
+		std::string bytes = image.str();
+		std::stringstream truncated(bytes.substr(0, bytes.size() - 2), std::ios::in | std::ios::binary);
+		deserialize<hashed_set_int_type>(truncated);
+		assert(false); //an exception should be thrown
+	}
+	catch(const invalid_image_exception &e) 
+	{
+		/* okay */
+	}
+	try 
+	{
+		// the last record overwritten with a copy of the first one
+		std::string bytes = image.str();
+		bytes.replace(bytes.size() - sizeof(int), sizeof(int), bytes, sizeof(set_image_header), sizeof(int));
+		std::stringstream damaged(bytes, std::ios::in | std::ios::binary);
+		deserialize<hashed_set_int_type>(damaged);
+		assert(false); //an exception should be thrown
+	}
+	catch(const invalid_image_exception &e) 
+	{
+		/* okay */
+	}
+
+	// a mapped set reads the image in place
+	const char* path = "test_set_image.bin";
+	{
+		std::ofstream file(path, std::ios::binary);
+		serialize(file, numbers, hash_int());
+	}
+	{
+		mapped_set<int, equal_int, hash_int> mapped(path);
+		assert(1000 == mapped.size());
+		assert(mapped.contains(0));
+		assert(mapped.contains(2997));
+		assert(!mapped.contains(2998));
+		assert(3 == *(mapped.find(0) + 1));
+		assert(mapped.end() == mapped.find(1));
+		int expected = 0;
+		for (mapped_set<int, equal_int, hash_int>::const_iterator it = mapped.begin(); it != mapped.end(); ++it, expected += 3)
+			assert(expected == *it);
+
+		// without the index the elements are scanned
+		mapped_set<int, equal_int> scanned(path);
+		assert(scanned.contains(1500));
+		assert(0 == scanned.count(1501));
+	}
+	{
+		std::ofstream file(path, std::ios::binary);
+		serialize(file, numbers);
+	}
+	try 
+	{
+		mapped_set<int, equal_int, hash_int> mapped(path);
+		assert(false); //an exception should be thrown
+	}
+	catch(const invalid_image_exception &e) 
+	{
+		/* okay */
+	}
+	std::remove(path);
+}
+
+
+void testBulkWriter() 
+{
+	// the text is the same of operator<<
+	hashed_set_int_type numbers;
+	for (int i = -500; i < 500; ++i)
+		numbers.add(i * 7);
+	std::ostringstream expected, written;
+	expected << numbers;
+	write_all(written, numbers);
+	assert(expected.str() == written.str());
+
+	set_string_type names;
+	names.add("Simone");
+	names.add("Carlo");
+	std::ostringstream namesWritten;
+	write_all(namesWritten, names, ", ");
+	assert("Simone, Carlo, " == namesWritten.str());
+
+	hashed_set_student_type students;
+	students.add(student(21, "Simone"));
+	students.add(student(13, "Carlo"));
+	std::ostringstream expectedStudents, writtenStudents;
+	expectedStudents << students;
+	write_all(writtenStudents, students);
+	assert(expectedStudents.str() == writtenStudents.str());
+
+	// floating point numbers are written in place, with the default format of a stream
+	flat_set<double, std::equal_to<double> > reals;
+	reals.add(0.5);
+	reals.add(-2.25);
+	reals.add(1.0 / 3);
+	reals.add(123456789.0);
+	reals.add(1e-7);
+	reals.add(-1e300);
+	std::ostringstream expectedReals, writtenReals;
+	expectedReals << reals;
+	write_all(writtenReals, reals);
+	assert(expectedReals.str() == writtenReals.str());
+
+	// types without a text format go through their operator<<
+	flat_set<char, std::equal_to<char> > letters;
+	letters.add('S');
+	letters.add('C');
+	std::ostringstream expectedLetters, writtenLetters;
+	expectedLetters << letters;
+	write_all(writtenLetters, letters);
+	assert(expectedLetters.str() == writtenLetters.str());
+
+	// small chunks are written as they fill up, the rest on flush
+	std::ostringstream chunked;
+	{
+		bulk_writer writer(chunked, "\n", 16);
+		writer.write_all(numbers);
+		assert(!chunked.str().empty());
+		assert(chunked.str().size() < expected.str().size());
+	}
+	assert(expected.str() == chunked.str());
+}
+
+
+template <typename Set>
+void assertSameSets(const Set &expected, const Set &actual) 
+{
+	assert(expected.size() == actual.size());
+	for (typename Set::const_iterator ie = expected.begin(), ia = actual.begin(); ie != expected.end(); ++ie, ++ia)
+		assert(*ie == *ia);
+}
+
+
+void testParallelBuild() 
+{
+	// the first occurrences are kept in order, whatever the number of threads
+	std::vector<int> numbers;
+	unsigned int state = 12345;
+	for (int i = 0; i < 100000; ++i) 
+	{
+		state = state * 1103515245u + 12345u;
+		numbers.push_back(static_cast<int>((state >> 8) % 30000));
+	}
+	hashed_set_int_type serial(numbers.begin(), numbers.end(), insert_or_ignore);
+	for (unsigned int threads = 1; threads <= 8; threads *= 2) 
+	{
+		hashed_set_int_type parallelSet(numbers.begin(), numbers.end(), insert_or_ignore, parallel(threads));
+		assertSameSets(serial, parallelSet);
+		for (int i = 0; i < 30000; i += 7)
+			assert(serial.contains(i) == parallelSet.contains(i));
+		parallelSet.add(-1);
+		parallelSet.remove(numbers[0]);
+		assert(!parallelSet.contains(numbers[0]));
+	}
+
+	// sequences that are not random access, and values converted to T
+	std::list<std::string> names;
+	for (int i = 0; i < 5000; ++i)
+		names.push_back("student" + std::to_string(i % 1234));
+	hashed_set_string_type serialNames(names.begin(), names.end(), insert_or_ignore);
+	hashed_set_string_type parallelNames(names.begin(), names.end(), insert_or_ignore, parallel(3));
+	assertSameSets(serialNames, parallelNames);
+	assert(1234 == parallelNames.size());
+	const char* words[] = {"a", "b", "a", "c", "b"};
+	hashed_set_string_type letters(words, words + 5, insert_or_ignore, parallel(2));
+	assert(3 == letters.size());
+	assert("c" == letters[2]);
+
+	std::vector<student> students;
+	for (unsigned int i = 0; i < 3000; ++i)
+		students.push_back(student(i % 40, "name" + std::to_string(i % 75)));
+	hashed_set_student_type serialStudents(students.begin(), students.end(), insert_or_ignore);
+	hashed_set_student_type parallelStudents(students.begin(), students.end(), insert_or_ignore, parallel(4));
+	assertSameSets(serialStudents, parallelStudents);
+
+	// allocators that cannot be shared by the threads, and sets without index
+	std::pmr::monotonic_buffer_resource resource;
+	pmr_set<int, equal_int, hash_int> pmrSet(numbers.begin(), numbers.end(), insert_or_ignore, parallel(4), &resource);
+	assert(serial.size() == pmrSet.size());
+	assert(serial[100] == pmrSet[100]);
+	set_int_type unhashed(numbers.begin(), numbers.begin() + 1000, insert_or_ignore, parallel(4));
+	hashed_set_int_type firstThousand(numbers.begin(), numbers.begin() + 1000, insert_or_ignore);
+	assert(firstThousand.size() == unhashed.size());
+
+	// empty and tiny sequences
+	assert(0 == hashed_set_int_type(numbers.begin(), numbers.begin(), insert_or_ignore, parallel(4)).size());
+	assert(1 == hashed_set_int_type(numbers.begin(), numbers.begin() + 1, insert_or_ignore, parallel(4)).size());
+}
+
+
+template <typename Set>
+void testBloomFilter() 
+{
+	bloom_set<Set, hash_int> s;
+	for (int i = 0; i < 1000; ++i)
+		s.add(i * 2);
+	assert(1000 == s.size());
+
+	// no false negatives, and few false positives
+	int positives = 0;
+	for (int i = 0; i < 2000; ++i) 
+	{
+		assert(s.contains(i * 2) == (i < 1000));
+		assert(s.might_contain(i * 2) || i >= 1000);
+		if (s.might_contain(i * 2 + 1))
+			++positives;
+		assert(!s.contains(i * 2 + 1));
+	}
+	assert(positives < 100);
+	assert(s.false_positive_rate() > 0 && s.false_positive_rate() < 0.05);
+	assert(s.filter_bytes() > 0 && s.filter_bytes() <= 1000 * 8);
+
+	// the false positives are as few as estimated
+	{
+		bloom_set<Set, hash_int> large;
+		for (int i = 0; i < 5000; ++i)
+			large.add(i * 2);
+		int largePositives = 0;
+		for (int i = 0; i < 100000; ++i)
+			if (large.might_contain(i * 2 + 1))
+				++largePositives;
+		assert(largePositives <= 2 * large.false_positive_rate() * 100000 + 10);
+	}
+
+	// absent values are rejected
+	try 
+	{
+		s.remove(1);
+		assert(false); //an exception should be thrown
+	}
+	catch(const non_existent_element_exception &e) 
+	{
+		/* okay */
+	}
+	try 
+	{
+		s.add(2);
+		assert(false); //an exception should be thrown
+	}
+	catch(const duplicated_element_exception &e) 
+	{
+		/* okay */
+	}
+	assert(!s.try_remove(3));
+	assert(s.end() == s.find(3));
+	assert(10 == *s.find(10));
+
+	// removed values leave the filter when it is built again
+	for (int i = 0; i < 800; ++i)
+		s.remove(i * 2);
+	for (int i = 0; i < 4000; ++i)
+		assert(s.try_add(-1 - i));
+	for (int i = 0; i < 800; ++i)
+		assert(!s.contains(i * 2));
+	assert(s.contains(1600) && s.contains(-4000));
+	assert(s.false_positive_rate() < 0.05);
+
+	// operator+ checks the duplicates through the filter
+	bloom_set<Set, hash_int> odds;
+	for (int i = 0; i < 100; ++i)
+		odds.add(i * 2 + 1);
+	bloom_set<Set, hash_int> merged = s + odds;
+	assert(s.size() + 100 == merged.size());
+	assert(merged.contains(99) && merged.contains(1600));
+	try 
+	{
+		merged + odds;
+		assert(false); //an exception should be thrown
+	}
+	catch(const duplicated_element_exception &e) 
+	{
+		/* okay */
+	}
+	assert(100 == filter_out(odds, is_even()).size());
+}
+
+
+void testBloomFilterWithStudents() 
+{
+	bloom_set<hashed_set_student_type, hash_student> s(4);
+	s.add(student(21, "Simone"));
+	s.emplace(13, "Carlo");
+	assert(s.contains(student(13, "Carlo")));
+	assert(!s.contains(student(14, "Carlo")));
+	bloom_set<hashed_set_student_type, hash_student> copy(s);
+	copy.add(student(14, "Carlo"));
+	assert(2 == s.size() && 3 == copy.size());
+	assert(4 == copy.bits_per_element());
+}
+
+
+void testStats() 
+{
+	// a set without index
+	set_int_type plain;
+	assert(0 == plain.stats().elements && 0 == plain.stats().allocated_bytes);
+	for (int i = 0; i < 100; ++i)
+		plain.add(i);
+	set_stats plainStats = plain.stats();
+	assert(100 == plainStats.elements);
+	assert(!plainStats.hashed && 0 == plainStats.index_bytes);
+	assert(plainStats.storage_bytes == 100 * plainStats.element_bytes);
+	assert(0 == plainStats.fragmentation);
+
+	// the chain histogram covers every bucket and every element
+	hashed_set_int_type hashed;
+	for (int i = 0; i < 1000; ++i)
+		hashed.add(i * 37);
+	set_stats hashedStats = hashed.stats();
+	assert(hashedStats.hashed);
+	assert(hashedStats.buckets >= 1000);
+	assert(hashedStats.load_factor == 1000.0 / hashedStats.buckets);
+	std::size_t buckets = 0, elements = 0;
+	for (std::size_t k = 0; k < hashedStats.chain_lengths.size(); ++k) 
+	{
+		buckets += hashedStats.chain_lengths[k];
+		elements += k * hashedStats.chain_lengths[k];
+	}
+	assert(hashedStats.buckets == buckets && 1000 == elements);
+	assert(hashedStats.longest_chain + 1 == hashedStats.chain_lengths.size());
+	assert(hashedStats.bytes_per_element > hashedStats.element_bytes);
+
+	// the free nodes of a pool are fragmentation
+	pooled_set<int, equal_int, hash_int> pooled;
+	for (int i = 0; i < 1000; ++i)
+		pooled.add(i);
+	double before = pooled.stats().fragmentation;
+	for (int i = 0; i < 900; ++i)
+		pooled.remove(i);
+	set_stats pooledStats = pooled.stats();
+	assert(pooledStats.fragmentation > before && pooledStats.fragmentation > 0.5);
+	assert(pooledStats.allocated_bytes > pooledStats.storage_bytes + pooledStats.index_bytes);
+
+	// the probe histogram of flat_set covers every element
+	hashed_flat_set_int_type flat;
+	for (int i = 0; i < 1000; ++i)
+		flat.add(i * 37);
+	set_stats flatStats = flat.stats();
+	std::size_t found = 0;
+	for (std::size_t k = 0; k < flatStats.probe_lengths.size(); ++k)
+		found += flatStats.probe_lengths[k];
+	assert(1000 == found && flatStats.probe_lengths[0] > 0);
+	assert(flatStats.longest_chain == flatStats.probe_lengths.size());
+	assert(flatStats.load_factor <= 0.75);
+
+	// dumps
+	std::ostringstream dump;
+	hashed.dump(dump, 2);
+	assert(dump.str().find("elements 1000\n") == 0);
+	assert(dump.str().find("chain_lengths ") != std::string::npos);
+	assert(dump.str().find("bucket ") != std::string::npos);
+	std::ostringstream flatDump;
+	flat.dump(flatDump);
+	assert(flatDump.str().find("probe_lengths 1:") != std::string::npos);
+	assert(flatDump.str().find("slot ") != std::string::npos);
+}
+
+
+void testSetMetrics() 
+{
+	// the registry and its dumps
+	set_metrics &metrics = set_metrics::global();
+	metrics.reset();
+	metrics.record(set_op_remove, 3, 5, 7);
+	metrics.record(set_op_remove, 1000, 0, 0);
+	const set_operation_metrics &removes = metrics.operation(set_op_remove);
+	assert(2 == removes.calls && 5 == removes.equal_calls && 7 == removes.nodes_visited);
+	assert(1003 == removes.nanoseconds);
+	assert(1 == removes.latency[2] && 1 == removes.latency[10]);
+
+	std::ostringstream json;
+	metrics.write_json(json);
+	assert(json.str().find("\"remove\":{\"calls\":2,\"equal_calls\":5,\"nodes_visited\":7,\"nanoseconds\":1003,"
+		"\"latency_ns\":[{\"le\":4,\"count\":1},{\"le\":1024,\"count\":1}]}") != std::string::npos);
+	assert(json.str().find("\"add\":{\"calls\":0,") == 1);
+
+	std::ostringstream prometheus;
+	metrics.write_prometheus(prometheus);
+	assert(prometheus.str().find("# TYPE set_operation_calls_total counter\n") != std::string::npos);
+	assert(prometheus.str().find("set_operation_calls_total{operation=\"remove\"} 2\n") != std::string::npos);
+	assert(prometheus.str().find("set_operation_latency_seconds_bucket{operation=\"remove\",le=\"+Inf\"} 2\n") != std::string::npos);
+	assert(prometheus.str().find("set_operation_latency_seconds_count{operation=\"remove\"} 2\n") != std::string::npos);
+	assert(prometheus.str().find("set_operation_latency_seconds_bucket{operation=\"remove\",le=\"0.000000004\"} 1\n") != std::string::npos);
+	assert(prometheus.str().find("set_operation_latency_seconds_bucket{operation=\"remove\",le=\"0.000001024\"} 2\n") != std::string::npos);
+	assert(prometheus.str().find("set_operation_latency_seconds_bucket{operation=\"remove\",le=\"68.719476736\"} 2\n") != std::string::npos);
+	assert(prometheus.str().find("set_operation_latency_seconds_sum{operation=\"remove\"} 0.000001003\n") != std::string::npos);
+
+	// the bounds are inclusive: a call of exactly 2^k ns is counted in bucket k
+	metrics.reset();
+	metrics.record(set_op_add, 1024, 0, 0);
+	metrics.record(set_op_add, 1025, 0, 0);
+	metrics.record(set_op_add, 1, 0, 0);
+	assert(1 == metrics.operation(set_op_add).latency[10]);
+	assert(1 == metrics.operation(set_op_add).latency[11]);
+	assert(1 == metrics.operation(set_op_add).latency[0]);
+	metrics.reset();
+	assert(0 == metrics.operation(set_op_remove).calls);
+
+#ifdef SET_INSTRUMENTATION
+	// the work of each operation is counted
+	set_int_type s;
+	for (int i = 0; i < 100; ++i)
+		s.add(i);
+	assert(100 == metrics.operation(set_op_add).calls);
+	assert(4950 == metrics.operation(set_op_add).equal_calls);
+	assert(4950 == metrics.operation(set_op_add).nodes_visited);
+
+	assert(!s.try_remove(-1));
+	assert(1 == metrics.operation(set_op_remove).calls);
+	assert(100 == metrics.operation(set_op_remove).equal_calls);
+
+	assert(50 == s[50]);
+	assert(1 == metrics.operation(set_op_subscript).calls);
+	assert(50 == metrics.operation(set_op_subscript).nodes_visited);
+
+	// the adds made by operator+ are part of it
+	set_int_type other;
+	other.add(-1);
+	other.add(-2);
+	metrics.reset();
+	set_int_type sum = s + other;
+	assert(102 == sum.size());
+	assert(1 == metrics.operation(set_op_plus).calls);
+	assert(0 == metrics.operation(set_op_add).calls);
+	assert(100 + 101 == metrics.operation(set_op_plus).equal_calls);
+
+	filter_out(s, is_even());
+	assert(1 == metrics.operation(set_op_filter_out).calls);
+	assert(100 == metrics.operation(set_op_filter_out).nodes_visited);
+
+	// a hashed set compares only the elements with the same hash
+	hashed_set_int_type hashed;
+	metrics.reset();
+	for (int i = 0; i < 1000; ++i)
+		hashed.add(i);
+	assert(0 == metrics.operation(set_op_add).equal_calls);
+	std::size_t total = 0;
+	for (std::size_t k = 0; k < set_operation_metrics::latency_buckets; ++k)
+		total += metrics.operation(set_op_add).latency[k];
+	assert(1000 == total);
+	metrics.reset();
+#endif
+}
+
 
 // == MAIN FUNCTION ==
 
@@ -798,5 +2731,94 @@ int main(int argc, char *argv[])
 	test_operatorPlus_studentType();
 	testStreamOperatorStudentType();
 
+	//test hashed sets
+	testHashedSetWithIntegers();
+	testHashedSetWithStudentType();
+	testMembership();
+	testHugeSet();
+	testAllocators();
+
+	//test flat sets
+	testFlatSetWithIntegers<flat_set_int_type>();
+	testFlatSetWithIntegers<hashed_flat_set_int_type>();
+	testFlatSetWithStudentType();
+
+	//test move semantics
+	testMoveSemantics();
+
+	//test bulk construction
+	testBulkConstruction();
+
+	//test positional access
+	testPositionalAccess();
+
+	//test ordered sets
+	testOrderedSet();
+
+	//test non-throwing insertion and removal
+	testTryAddRemove<set_int_type>();
+	testTryAddRemove<hashed_set_int_type>();
+	testTryAddRemove<flat_set_int_type>();
+	testTryAddRemove<hashed_flat_set_int_type>();
+	testTryAddRemove<ordered_set_int_type>();
+	testTryAddAllocatesNothing();
+
+	//test set algebra
+	testSetAlgebra<set_int_type>();
+	testSetAlgebra<hashed_set_int_type>();
+	testSetAlgebra<ordered_set_int_type>();
+	testHashedSetAlgebra();
+
+	//test filter views
+	testFilterViews<set_int_type>();
+	testFilterViews<hashed_set_int_type>();
+	testFilterViews<flat_set_int_type>();
+	testFilterViews<hashed_flat_set_int_type>();
+	testFilterViews<ordered_set_int_type>();
+	testFilterViewWithStudentType();
+
+	//test parallel filter
+	testParallelFilter<set_int_type>();
+	testParallelFilter<hashed_set_int_type>();
+	testParallelFilter<flat_set_int_type>();
+	testParallelFilter<ordered_set_int_type>();
+
+	//test parallel construction
+	testParallelBuild();
+
+	//test vectorized scans
+	testSimdScan();
+
+	//test copies
+	testCopies();
+
+	//test small sets
+	testSmallSet();
+
+	//test concurrent sets
+	testConcurrentSet();
+
+	//test copy-on-write sets
+	testCopyOnWrite();
+
+	//test statistics
+	testStats();
+
+	//test instrumentation
+	testSetMetrics();
+
+	//test bloom filters
+	testBloomFilter<set_int_type>();
+	testBloomFilter<hashed_set_int_type>();
+	testBloomFilter<flat_set_int_type>();
+	testBloomFilter<ordered_set_int_type>();
+	testBloomFilterWithStudents();
+
+	//test binary images
+	testSerialization();
+
+	//test bulk output
+	testBulkWriter();
+
 	return 0;
 }
@@ -0,0 +1,9 @@
+#include "invalid_image_exception.h"
+
+invalid_image_exception::invalid_image_exception() 
+	: std::runtime_error("") 
+{}
+
+invalid_image_exception::invalid_image_exception(const std::string &message) 
+	: std::runtime_error(message) 
+{}
@@ -0,0 +1,133 @@
+#include "node_pool.h"
+
+namespace 
+{
+	const std::size_t firstSlabNodes = 32;    // nodes in the first slab
+	const std::size_t maxSlabNodes = 65536;   // nodes in the largest slabs
+	const std::size_t alignment = alignof(std::max_align_t);
+
+	std::size_t roundUp(std::size_t n) 
+	{
+		return (n + alignment - 1) / alignment * alignment;
+	}
+}
+
+node_pool::node_pool() 
+	: _nodeSize(0), _stride(0), _nextSlab(firstSlabNodes), _slabs(0), _free(0), 
+	  _cursor(0), _limit(0), _inUse(0), _reserved(0), _outside(0) 
+{}
+
+node_pool::~node_pool() 
+{
+	release();
+}
+
+void node_pool::grow() 
+{
+	std::size_t header = roundUp(sizeof(slab));
+	char* memory = static_cast<char*>(::operator new(header + _nextSlab * _stride));
+	slab* s = reinterpret_cast<slab*>(memory);
+	s->next = _slabs;
+	s->nodes = _nextSlab;
+	_slabs = s;
+	_cursor = memory + header;
+	_limit = _cursor + _nextSlab * _stride;
+	_reserved += _nextSlab;
+	if (_nextSlab < maxSlabNodes)
+		_nextSlab *= 2;
+}
+
+void* node_pool::allocate(std::size_t size) 
+{
+	if (_nodeSize == 0) 
+	{
+		_nodeSize = size;
+		_stride = roundUp(size < sizeof(free_node) ? sizeof(free_node) : size);
+	}
+	else if (size != _nodeSize)
+		return 0;
+
+	void* p;
+	if (_free != 0) 
+	{
+		p = _free;
+		_free = _free->next;
+	}
+	else 
+	{
+		if (_cursor == _limit)
+			grow();
+		p = _cursor;
+		_cursor += _stride;
+	}
+	++_inUse;
+	return p;
+}
+
+bool node_pool::deallocate(void* p, std::size_t size) 
+{
+	if (size != _nodeSize)
+		return false;
+	free_node* node = static_cast<free_node*>(p);
+	node->next = _free;
+	_free = node;
+	--_inUse;
+	return true;
+}
+
+void node_pool::release() 
+{
+	while (_slabs != 0) 
+	{
+		slab* tmp = _slabs;
+		_slabs = _slabs->next;
+		::operator delete(tmp);
+	}
+	_free = 0;
+	_cursor = 0;
+	_limit = 0;
+	_inUse = 0;
+	_reserved = 0;
+	_nextSlab = firstSlabNodes;
+}
+
+void* node_pool::allocate_outside(std::size_t size) 
+{
+	void* p = ::operator new(size);
+	++_outside;
+	return p;
+}
+
+void node_pool::deallocate_outside(void* p) 
+{
+	::operator delete(p);
+	--_outside;
+}
+
+std::size_t node_pool::node_size() const 
+{
+	return _nodeSize;
+}
+
+std::size_t node_pool::nodes_in_use() const 
+{
+	return _inUse;
+}
+
+std::size_t node_pool::blocks_outside() const 
+{
+	return _outside;
+}
+
+std::size_t node_pool::nodes_reserved() const 
+{
+	return _reserved;
+}
+
+std::size_t node_pool::bytes_reserved() const 
+{
+	std::size_t bytes = 0;
+	for (const slab* s = _slabs; s != 0; s = s->next)
+		bytes += roundUp(sizeof(slab)) + s->nodes * _stride;
+	return bytes;
+}
@@ -0,0 +1,148 @@
+#include "set_metrics.h"
+#include <cstdio> // std::snprintf
+
+namespace
+{
+	const char* const operationNames[set_op_count] = {"add", "remove", "subscript", "filter_out", "plus"};
+
+	// bucket of a latency: the first k with ns <= 2^k, so that 2^k is its le bound
+	std::size_t bucketOf(unsigned long long nanoseconds)
+	{
+		std::size_t k = 0;
+		while ((1ull << k) < nanoseconds && k + 1 < set_operation_metrics::latency_buckets)
+			++k;
+		return k;
+	}
+
+	// write nanoseconds as seconds, with all their digits
+	void writeSeconds(std::ostream &os, unsigned long long nanoseconds)
+	{
+		char fraction[10];
+		std::snprintf(fraction, sizeof(fraction), "%09llu", nanoseconds % 1000000000ull);
+		os << nanoseconds / 1000000000ull << '.' << fraction;
+	}
+
+	unsigned long long load(const std::atomic<unsigned long long> &counter)
+	{
+		return counter.load(std::memory_order_relaxed);
+	}
+}
+
+set_operation_metrics::set_operation_metrics()
+{
+	reset();
+}
+
+void set_operation_metrics::reset()
+{
+	calls.store(0, std::memory_order_relaxed);
+	equal_calls.store(0, std::memory_order_relaxed);
+	nodes_visited.store(0, std::memory_order_relaxed);
+	nanoseconds.store(0, std::memory_order_relaxed);
+	for (std::size_t k = 0; k < latency_buckets; ++k)
+		latency[k].store(0, std::memory_order_relaxed);
+}
+
+set_metrics& set_metrics::global()
+{
+	static set_metrics registry;
+	return registry;
+}
+
+const char* set_metrics::name(set_operation op)
+{
+	return operationNames[op];
+}
+
+const set_operation_metrics& set_metrics::operation(set_operation op) const
+{
+	return _operations[op];
+}
+
+void set_metrics::record(set_operation op, unsigned long long nanoseconds, unsigned long long equalCalls, unsigned long long nodesVisited)
+{
+	set_operation_metrics &m = _operations[op];
+	m.calls.fetch_add(1, std::memory_order_relaxed);
+	m.equal_calls.fetch_add(equalCalls, std::memory_order_relaxed);
+	m.nodes_visited.fetch_add(nodesVisited, std::memory_order_relaxed);
+	m.nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+	m.latency[bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void set_metrics::reset()
+{
+	for (std::size_t op = 0; op < set_op_count; ++op)
+		_operations[op].reset();
+}
+
+void set_metrics::write_json(std::ostream &os) const
+{
+	os << '{';
+	for (std::size_t op = 0; op < set_op_count; ++op)
+	{
+		const set_operation_metrics &m = _operations[op];
+		os << (op == 0 ? "" : ",") << '"' << operationNames[op] << "\":{"
+		   << "\"calls\":" << load(m.calls)
+		   << ",\"equal_calls\":" << load(m.equal_calls)
+		   << ",\"nodes_visited\":" << load(m.nodes_visited)
+		   << ",\"nanoseconds\":" << load(m.nanoseconds)
+		   << ",\"latency_ns\":[";
+		bool first = true;
+		for (std::size_t k = 0; k < set_operation_metrics::latency_buckets; ++k)
+		{
+			unsigned long long count = load(m.latency[k]);
+			if (count == 0)
+				continue;
+			os << (first ? "" : ",") << "{\"le\":";
+			if (k + 1 == set_operation_metrics::latency_buckets)
+				os << "\"+Inf\"";
+			else
+				os << (1ull << k);
+			os << ",\"count\":" << count << '}';
+			first = false;
+		}
+		os << "]}";
+	}
+	os << "}\n";
+}
+
+void set_metrics::write_prometheus(std::ostream &os) const
+{
+	static const char* const counters[3][2] = {
+		{"set_operation_calls_total", "Completed calls of the operations of set"},
+		{"set_operation_equal_calls_total", "Calls of the equality functor made by the operations of set"},
+		{"set_operation_nodes_visited_total", "Elements visited by the operations of set"}
+	};
+	for (std::size_t c = 0; c < 3; ++c)
+	{
+		os << "# HELP " << counters[c][0] << ' ' << counters[c][1] << '\n'
+		   << "# TYPE " << counters[c][0] << " counter\n";
+		for (std::size_t op = 0; op < set_op_count; ++op)
+		{
+			const set_operation_metrics &m = _operations[op];
+			unsigned long long value = c == 0 ? load(m.calls) : c == 1 ? load(m.equal_calls) : load(m.nodes_visited);
+			os << counters[c][0] << "{operation=\"" << operationNames[op] << "\"} " << value << '\n';
+		}
+	}
+
+	os << "# HELP set_operation_latency_seconds Latency of the operations of set\n"
+	   << "# TYPE set_operation_latency_seconds histogram\n";
+	for (std::size_t op = 0; op < set_op_count; ++op)
+	{
+		const set_operation_metrics &m = _operations[op];
+		unsigned long long cumulative = 0;
+		for (std::size_t k = 0; k + 1 < set_operation_metrics::latency_buckets; ++k)
+		{
+			cumulative += load(m.latency[k]);
+			os << "set_operation_latency_seconds_bucket{operation=\"" << operationNames[op] << "\",le=\"";
+			writeSeconds(os, 1ull << k);
+			os << "\"} " << cumulative << '\n';
+		}
+		cumulative += load(m.latency[set_operation_metrics::latency_buckets - 1]);
+		os << "set_operation_latency_seconds_bucket{operation=\"" << operationNames[op] << "\",le=\"+Inf\"} " << cumulative << '\n'
+		   << "set_operation_latency_seconds_sum{operation=\"" << operationNames[op] << "\"} ";
+		writeSeconds(os, load(m.nanoseconds));
+		os << '\n'
+		   << "set_operation_latency_seconds_count{operation=\"" << operationNames[op] << "\"} " << cumulative << '\n';
+	}
+}
@@ -3,12 +3,15 @@
 student::student() : age(0), name("") 
 {}
 
-student::student(unsigned int a, std::string n) : age(a), name(n) 
+student::student(unsigned int a, std::string n) : age(a), name(std::move(n)) 
 {}
 
 student::student(const student& other) : age(other.age), name(other.name) 
 {}
 
+student::student(student&& other) noexcept : age(other.age), name(std::move(other.name)) 
+{}
+
 student& student::operator=(const student& other) 
 {
 	if (this != &other) {
@@ -19,6 +22,13 @@ student& student::operator=(const student& other)
 	return *this;
 }
 
+student& student::operator=(student&& other) noexcept 
+{
+	age = other.age;
+	name = std::move(other.name);
+	return *this;
+}
+
 student::~student() {}
 
 bool student::operator==(const student& other) const 
@@ -26,7 +36,7 @@ bool student::operator==(const student& other) const
 	return name == other.name && age == other.age;
 }
 
-std::ostream &operator<<(std::ostream &os, const student st) 
+std::ostream &operator<<(std::ostream &os, const student &st) 
 {
 	os << st.name << " " << st.age;
 	return os;